@@ -0,0 +1,254 @@
+/*
+ * Micro-benchmark of the candidate representation
+ * Compares the old layout (nine `unsigned short int` per cell) against the bitmask layout used by the solver,
+ * on the two queries the solver runs the most: naked singles over all cells and hidden singles over all units,
+ * and the versions of the vectorised scan of all 27 units against each other
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include "example_sudokus.h"
+#include "sudoku_solver.h"
+#include "sudoku_simd.h"
+
+#define BENCH_ROUNDS 200000
+
+typedef struct LegacyNotes {
+    unsigned short int values[9];
+} LegacyNotes;
+
+static LegacyNotes legacy_board[9][9];
+static unsigned short int mask_board[9][9];
+
+// Keeps the compiler from throwing away the work of the benchmarked loops
+static volatile unsigned long sink;
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Fills both layouts with the candidates left after removing the givens of `board` from their row, column and block
+ */
+static void load_board(unsigned short int board[9][9]) {
+    for (size_t i = 0; i < 9; i++)
+    {
+        for (size_t j = 0; j < 9; j++)
+        {
+            unsigned short int mask = 0x1FF;
+            if (board[i][j] != 0)
+            {
+                mask = 1u << (board[i][j] - 1);
+            }
+            else
+            {
+                for (size_t k = 0; k < 9; k++)
+                {
+                    const size_t bi = (i / 3) * 3 + k / 3;
+                    const size_t bj = (j / 3) * 3 + k % 3;
+                    if (board[i][k] != 0) mask &= ~(1u << (board[i][k] - 1));
+                    if (board[k][j] != 0) mask &= ~(1u << (board[k][j] - 1));
+                    if (board[bi][bj] != 0) mask &= ~(1u << (board[bi][bj] - 1));
+                }
+            }
+
+            mask_board[i][j] = mask;
+            for (size_t n = 0; n < 9; n++)
+            {
+                legacy_board[i][j].values[n] = (mask >> n) & 1 ? n + 1 : 0;
+            }
+        }
+    }
+}
+
+static unsigned long legacy_naked_singles() {
+    unsigned long found = 0;
+    for (size_t i = 0; i < 9; i++)
+    {
+        for (size_t j = 0; j < 9; j++)
+        {
+            unsigned short int candidate = 0;
+            int single = 1;
+            for (size_t n = 0; n < 9; n++)
+            {
+                if (candidate == 0)
+                {
+                    candidate = legacy_board[i][j].values[n];
+                }
+                else if (legacy_board[i][j].values[n] != 0)
+                {
+                    single = 0;
+                    break;
+                }
+            }
+            found += single ? candidate : 0;
+        }
+    }
+    return found;
+}
+
+static unsigned long mask_naked_singles() {
+    unsigned long found = 0;
+    for (size_t i = 0; i < 9; i++)
+    {
+        for (size_t j = 0; j < 9; j++)
+        {
+            const unsigned short int mask = mask_board[i][j];
+            found += __builtin_popcount(mask) == 1 ? (unsigned long)__builtin_ctz(mask) + 1 : 0;
+        }
+    }
+    return found;
+}
+
+static unsigned long legacy_hidden_singles() {
+    unsigned long found = 0;
+    for (size_t n = 0; n < 9; n++)
+    {
+        for (size_t u = 0; u < 9; u++)
+        {
+            unsigned short int row_count = 0, column_count = 0, block_count = 0;
+            for (size_t k = 0; k < 9; k++)
+            {
+                row_count += legacy_board[u][k].values[n] != 0;
+                column_count += legacy_board[k][u].values[n] != 0;
+                block_count += legacy_board[(u / 3) * 3 + k / 3][(u % 3) * 3 + k % 3].values[n] != 0;
+            }
+            found += (row_count == 1) + (column_count == 1) + (block_count == 1);
+        }
+    }
+    return found;
+}
+
+static unsigned long mask_hidden_singles() {
+    unsigned long found = 0;
+    for (size_t u = 0; u < 9; u++)
+    {
+        unsigned short int row_once = 0, row_twice = 0;
+        unsigned short int column_once = 0, column_twice = 0;
+        unsigned short int block_once = 0, block_twice = 0;
+        for (size_t k = 0; k < 9; k++)
+        {
+            const unsigned short int row_cell = mask_board[u][k];
+            const unsigned short int column_cell = mask_board[k][u];
+            const unsigned short int block_cell = mask_board[(u / 3) * 3 + k / 3][(u % 3) * 3 + k % 3];
+            row_twice |= row_once & row_cell;
+            row_once |= row_cell;
+            column_twice |= column_once & column_cell;
+            column_once |= column_cell;
+            block_twice |= block_once & block_cell;
+            block_once |= block_cell;
+        }
+        found += __builtin_popcount(row_once & ~row_twice);
+        found += __builtin_popcount(column_once & ~column_twice);
+        found += __builtin_popcount(block_once & ~block_twice);
+    }
+    return found;
+}
+
+static double time_query(unsigned long (*query)()) {
+    const double start = now_ns();
+    for (size_t r = 0; r < BENCH_ROUNDS; r++)
+    {
+        sink += query();
+        // Stops the compiler from hoisting the query out of the loop, the board could have changed
+        __asm__ __volatile__("" ::: "memory");
+    }
+    return (now_ns() - start) / BENCH_ROUNDS;
+}
+
+static void bench_board(const char *name, unsigned short int board[9][9]) {
+    load_board(board);
+
+    if (legacy_naked_singles() != mask_naked_singles() || legacy_hidden_singles() != mask_hidden_singles())
+    {
+        printf("%s: layouts disagree, results are not comparable\n", name);
+        return;
+    }
+
+    const double legacy_naked = time_query(legacy_naked_singles);
+    const double mask_naked = time_query(mask_naked_singles);
+    const double legacy_hidden = time_query(legacy_hidden_singles);
+    const double mask_hidden = time_query(mask_hidden_singles);
+
+    printf("%-6s naked singles:  %8.1f ns -> %8.1f ns  (%.1fx)\n", name, legacy_naked, mask_naked, legacy_naked / mask_naked);
+    printf("%-6s hidden singles: %8.1f ns -> %8.1f ns  (%.1fx)\n", name, legacy_hidden, mask_hidden, legacy_hidden / mask_hidden);
+}
+
+static void bench_scan_units(const char *name, unsigned short int board[9][9]) {
+    const struct {
+        const char *version;
+        ScanUnitsFunction scan;
+    } versions[] = {
+        { "scalar", scan_units_scalar_version() },
+        { "sse2", scan_units_sse2_version() },
+        { "avx2", scan_units_avx2_version() },
+    };
+    SudokuSolver solver;
+    Notes expected_once[SCAN_UNITS], expected_twice[SCAN_UNITS], once[SCAN_UNITS], twice[SCAN_UNITS];
+
+    load_board(board);
+    sudoku_solver_init(&solver);
+    memcpy(solver.candidates, mask_board, sizeof(mask_board));
+    versions[0].scan(&solver, expected_once, expected_twice);
+
+    for (size_t v = 0; v < sizeof(versions) / sizeof(versions[0]); v++)
+    {
+        if (versions[v].scan == NULL)
+        {
+            printf("%-6s scan units %-6s  not supported by this CPU\n", name, versions[v].version);
+            continue;
+        }
+
+        versions[v].scan(&solver, once, twice);
+        if (memcmp(once, expected_once, sizeof(once)) != 0 || memcmp(twice, expected_twice, sizeof(twice)) != 0)
+        {
+            printf("%-6s scan units %-6s  disagrees with scalar\n", name, versions[v].version);
+            continue;
+        }
+
+        const double start = now_ns();
+        for (size_t r = 0; r < BENCH_ROUNDS; r++)
+        {
+            versions[v].scan(&solver, once, twice);
+            sink += once[r % SCAN_UNITS];
+            __asm__ __volatile__("" ::: "memory");
+        }
+        printf("%-6s scan units %-6s  %8.1f ns\n", name, versions[v].version, (now_ns() - start) / BENCH_ROUNDS);
+    }
+}
+
+static void bench_solve(const char *name, unsigned short int board[9][9]) {
+    unsigned short int solved[9][9];
+    const size_t rounds = BENCH_ROUNDS / 10;
+
+    const double start = now_ns();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        solve_sudoku(board, solved);
+        sink += solved[0][0];
+    }
+    printf("%-6s solve_sudoku:   %8.1f ns\n", name, (now_ns() - start) / rounds);
+}
+
+int main() {
+    printf("Candidate layout: %zu bytes per board (nine values per cell) -> %zu bytes per board (bitmask per cell)\n",
+           sizeof(legacy_board), sizeof(mask_board));
+
+    bench_board("easy1", easy1);
+    bench_board("easy2", easy2);
+    bench_board("med1", med1);
+    bench_board("hard1", hard1);
+
+    printf("Scan of all 27 units used by the solver: %s\n", scan_units_version());
+    bench_scan_units("med1", med1);
+    bench_scan_units("hard1", hard1);
+
+    bench_solve("easy1", easy1);
+    bench_solve("easy2", easy2);
+
+    return 0;
+}
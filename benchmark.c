@@ -0,0 +1,531 @@
+/*
+ * Benchmark of the solver over the graded corpora in `puzzles/`
+ * Every corpus is solved with the fast path (singles and guessing) and with the human style strategies,
+ * on one thread, for long enough to get stable timings. A table is printed on stderr and one JSON object per
+ * corpus on stdout, so runs can be saved and compared: `./benchmark > before.jsonl`, change the solver, then
+ * `./benchmark --baseline before.jsonl` prints how much every corpus got faster or slower
+ * Last, the hardest boards are solved one at a time on 1, 2, 4... threads up to one per core, to see how much the
+ * parallel search of a single board cuts its latency
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "sudoku_solver.h"
+#include "sudoku_strategies.h"
+#include "sudoku_trace.h"
+#include "sudoku_batch.h"
+#include "sudoku_io.h"
+#include "sudoku_lockstep.h"
+#include "sudoku_grid.h"
+#include "sudoku_cache.h"
+#include "sudoku_util.h"
+
+// Every measurement repeats the whole corpus until at least this much time has passed
+#define MIN_BENCH_SECONDS 0.5
+#define MAX_CORPUS_PUZZLES 100000
+
+typedef struct Corpus {
+    const char *name;
+    const char *path;
+} Corpus;
+
+static const Corpus corpora[] = {
+    { "easy",    "puzzles/easy.txt" },
+    { "medium",  "puzzles/medium.txt" },
+    { "hard",    "puzzles/hard.txt" },
+    { "expert",  "puzzles/expert.txt" },
+    { "17clue",  "puzzles/17clue.txt" },
+    { "hardest", "puzzles/hardest.txt" },
+};
+
+// Boards of other sizes, only timed with `sudoku_grid_solve`
+static const Corpus grid_corpora[] = {
+    { "16x16",   "puzzles/16x16.txt" },
+    { "25x25",   "puzzles/25x25.txt" },
+};
+
+// Single boards solved with `sudoku_grid_solve_parallel` on more and more threads, timed one by one
+static const Corpus latency_corpora[] = {
+    { "hardest",    "puzzles/hardest.txt" },
+    { "25x25-hard", "puzzles/25x25-hard.txt" },
+};
+
+#define MAX_GRID_CORPUS_PUZZLES 1000
+// Big enough to hold every corpus, so only repeats of a puzzle within a pass hit
+#define CACHE_CAPACITY 4096
+
+typedef struct CorpusResult {
+    size_t puzzles;
+    size_t solved;
+    double ns_per_puzzle;
+    // Whole corpus through `sudoku_lockstep_solve`, same results as the fast path
+    double lockstep_ns_per_puzzle;
+    // Whole corpus through a solution cache emptied before every pass, and the share of puzzles it already had
+    double cache_ns_per_puzzle;
+    double cache_hit_rate;
+    // Solved by the strategies without any guessing
+    size_t logic_solved;
+    double logic_ns_per_puzzle;
+    double mean_difficulty;
+} CorpusResult;
+
+typedef struct LatencyResult {
+    size_t puzzles;
+    size_t solved;
+    // Best time of every puzzle over the passes, averaged and at worst
+    double mean_ns;
+    double worst_ns;
+} LatencyResult;
+
+typedef int (*SolveFunction)(SudokuSolver *solver, unsigned short int input[9][9], unsigned short int output[9][9]);
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int solve_fast(SudokuSolver *solver, unsigned short int input[9][9], unsigned short int output[9][9]) {
+    return sudoku_solver_solve(solver, input, output);
+}
+
+static int solve_logic(SudokuSolver *solver, unsigned short int input[9][9], unsigned short int output[9][9]) {
+    return sudoku_solver_solve_with_strategies(solver, sudoku_default_strategies, sudoku_default_strategy_count, NULL, input, output);
+}
+
+/*
+ * Return 0 if `output` is not a complete, valid grid that keeps every given of `input`, >0 otherwise
+ */
+static int is_solution(unsigned short int input[9][9], unsigned short int output[9][9]) {
+    Notes rows[9] = {0}, columns[9] = {0}, blocks[9] = {0};
+    for (size_t i = 0; i < 9; i++)
+    {
+        for (size_t j = 0; j < 9; j++)
+        {
+            const unsigned short int n = output[i][j];
+            if (n < 1 || n > 9 || (input[i][j] != 0 && input[i][j] != n))
+            {
+                return 0;
+            }
+            rows[i] |= NOTES_BIT(n);
+            columns[j] |= NOTES_BIT(n);
+            blocks[(i / 3) * 3 + j / 3] |= NOTES_BIT(n);
+        }
+    }
+    for (size_t k = 0; k < 9; k++)
+    {
+        if (rows[k] != NOTES_ALL_VALUES || columns[k] != NOTES_ALL_VALUES || blocks[k] != NOTES_ALL_VALUES)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Solves the whole corpus with `solve` as many times as fits in MIN_BENCH_SECONDS (at least once)
+ * Return the average time per puzzle, in nanoseconds
+ */
+static double time_corpus(SolveFunction solve, SudokuBoard *inputs, SudokuBoard *outputs, size_t count) {
+    SudokuSolver solver;
+    size_t passes = 0;
+    const double start = now_ns();
+    double elapsed;
+    do
+    {
+        for (size_t k = 0; k < count; k++)
+        {
+            solve(&solver, inputs[k], outputs[k]);
+        }
+        passes++;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_BENCH_SECONDS * 1e9);
+
+    return elapsed / (passes * count);
+}
+
+/*
+ * Same as `time_corpus`, for `sudoku_lockstep_solve`
+ * Return the average time per puzzle, in nanoseconds
+ */
+static double time_lockstep(SudokuBoard *inputs, SudokuBoard *outputs, size_t count) {
+    size_t passes = 0;
+    const double start = now_ns();
+    double elapsed;
+    do
+    {
+        sudoku_lockstep_solve(inputs, outputs, NULL, NULL, count);
+        passes++;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_BENCH_SECONDS * 1e9);
+
+    return elapsed / (passes * count);
+}
+
+/*
+ * Same as `time_corpus`, through `cache`, which is emptied before every pass
+ * Return the average time per puzzle, in nanoseconds
+ */
+static double time_cache(SudokuCache *cache, SudokuBoard *inputs, SudokuBoard *outputs, size_t count) {
+    SudokuSolver solver;
+    size_t passes = 0;
+    const double start = now_ns();
+    double elapsed;
+    do
+    {
+        sudoku_cache_clear(cache);
+        for (size_t k = 0; k < count; k++)
+        {
+            sudoku_cache_solve(cache, &solver, inputs[k], outputs[k]);
+        }
+        passes++;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_BENCH_SECONDS * 1e9);
+
+    return elapsed / (passes * count);
+}
+
+static void bench_corpus(SudokuCache *cache, SudokuBoard *inputs, SudokuBoard *outputs, size_t count, CorpusResult *result) {
+    memset(result, 0, sizeof(*result));
+    result->puzzles = count;
+
+    // Counted as solved only if the lanes and the cache solved the puzzles as well
+    unsigned char *solved = malloc(count);
+    assert((count == 0 || solved != NULL) && "Out of memory for results");
+    result->ns_per_puzzle = time_corpus(solve_fast, inputs, outputs, count);
+    for (size_t k = 0; k < count; k++)
+    {
+        solved[k] = is_solution(inputs[k], outputs[k]);
+    }
+    result->lockstep_ns_per_puzzle = time_lockstep(inputs, outputs, count);
+    for (size_t k = 0; k < count; k++)
+    {
+        solved[k] &= is_solution(inputs[k], outputs[k]);
+    }
+    result->cache_ns_per_puzzle = time_cache(cache, inputs, outputs, count);
+    result->cache_hit_rate = sudoku_cache_hit_rate(cache);
+    for (size_t k = 0; k < count; k++)
+    {
+        solved[k] &= is_solution(inputs[k], outputs[k]);
+        result->solved += solved[k];
+    }
+    free(solved);
+
+    // The grading pass is not timed, the trace only tells which puzzles needed a guess
+    SudokuSolver solver;
+    SudokuTrace trace;
+    double difficulty = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        const double grade = sudoku_solver_grade(&solver, &trace, inputs[k], outputs[k]);
+        if (grade >= 0)
+        {
+            difficulty += grade;
+            result->logic_solved += trace.guesses == 0 && is_solution(inputs[k], outputs[k]);
+        }
+    }
+    result->mean_difficulty = count > 0 ? difficulty / count : 0;
+    result->logic_ns_per_puzzle = time_corpus(solve_logic, inputs, outputs, count);
+}
+
+/*
+ * Return 0 if `solution` is not a complete, valid grid that keeps every given of `puzzle`, >0 otherwise
+ */
+static int is_grid_solution(const SudokuGrid *puzzle, const SudokuGrid *solution) {
+    const size_t side = puzzle->side, box = puzzle->box;
+    const unsigned int all_values = (1u << side) - 1;
+    unsigned int rows[SUDOKU_GRID_MAX_SIDE] = {0}, columns[SUDOKU_GRID_MAX_SIDE] = {0}, boxes[SUDOKU_GRID_MAX_SIDE] = {0};
+    for (size_t cell = 0; cell < side * side; cell++)
+    {
+        const size_t i = cell / side, j = cell % side;
+        const unsigned int n = solution->cells[cell];
+        if (n < 1 || n > side || (puzzle->cells[cell] != 0 && puzzle->cells[cell] != n))
+        {
+            return 0;
+        }
+        rows[i] |= 1u << (n - 1);
+        columns[j] |= 1u << (n - 1);
+        boxes[(i / box) * box + j / box] |= 1u << (n - 1);
+    }
+    for (size_t k = 0; k < side; k++)
+    {
+        if (rows[k] != all_values || columns[k] != all_values || boxes[k] != all_values)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Times `sudoku_grid_solve` over the puzzles of `path`, as many passes as fit in MIN_BENCH_SECONDS
+ * Return 0 if the file could not be read, >0 otherwise
+ */
+static int bench_grid_corpus(const char *path, SudokuGrid *puzzles, SudokuGrid *solutions, CorpusResult *result) {
+    SudokuReader reader;
+    if (!sudoku_reader_open(&reader, path))
+    {
+        return 0;
+    }
+    memset(result, 0, sizeof(*result));
+    while (result->puzzles < MAX_GRID_CORPUS_PUZZLES && sudoku_reader_next_grid(&reader, &puzzles[result->puzzles]))
+    {
+        result->puzzles++;
+    }
+    sudoku_reader_close(&reader);
+    if (result->puzzles == 0)
+    {
+        return 1;
+    }
+
+    size_t passes = 0;
+    const double start = now_ns();
+    double elapsed;
+    do
+    {
+        for (size_t k = 0; k < result->puzzles; k++)
+        {
+            sudoku_grid_solve(&puzzles[k], &solutions[k]);
+        }
+        passes++;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_BENCH_SECONDS * 1e9);
+    result->ns_per_puzzle = elapsed / (passes * result->puzzles);
+
+    for (size_t k = 0; k < result->puzzles; k++)
+    {
+        result->solved += is_grid_solution(&puzzles[k], &solutions[k]);
+    }
+    return 1;
+}
+
+/*
+ * Times every puzzle on its own with `sudoku_grid_solve_parallel` on `threads` threads, as many passes as fit in
+ * MIN_BENCH_SECONDS and at least one, keeping the best time of each so that the noise of other processes stays out
+ */
+static void time_latency(const SudokuGrid *puzzles, SudokuGrid *solutions, double *best_ns, size_t count,
+                         unsigned int threads, LatencyResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->puzzles = count;
+    const double start = now_ns();
+    for (size_t pass = 0; pass == 0 || now_ns() - start < MIN_BENCH_SECONDS * 1e9; pass++)
+    {
+        for (size_t k = 0; k < count; k++)
+        {
+            const double puzzle_start = now_ns();
+            sudoku_grid_solve_parallel(&puzzles[k], &solutions[k], threads);
+            const double elapsed = now_ns() - puzzle_start;
+            best_ns[k] = pass == 0 || elapsed < best_ns[k] ? elapsed : best_ns[k];
+        }
+    }
+
+    for (size_t k = 0; k < count; k++)
+    {
+        result->solved += is_grid_solution(&puzzles[k], &solutions[k]);
+        result->mean_ns += best_ns[k] / count;
+        result->worst_ns = best_ns[k] > result->worst_ns ? best_ns[k] : result->worst_ns;
+    }
+}
+
+/*
+ * Looks `corpus` up in a file of earlier results, as printed on stdout by this benchmark
+ * Return 0 if it is not there, >0 otherwise with its fast path and strategies timings (0 if it has none)
+ */
+static int find_baseline(const char *path, const char *corpus, double *ns_per_puzzle, double *logic_ns_per_puzzle) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    char line[1024], name[64];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file) != NULL)
+    {
+        const char *fast = strstr(line, "\"ns_per_puzzle\":");
+        const char *logic = strstr(line, "\"logic_ns_per_puzzle\":");
+        found = sscanf(line, "{\"corpus\":\"%63[^\"]\"", name) == 1 && strcmp(name, corpus) == 0
+                && fast != NULL && sscanf(fast, "\"ns_per_puzzle\":%lf", ns_per_puzzle) == 1;
+        // Corpora of other sizes are only timed with the fast path
+        if (found && (logic == NULL || sscanf(logic, "\"logic_ns_per_puzzle\":%lf", logic_ns_per_puzzle) != 1))
+        {
+            *logic_ns_per_puzzle = 0;
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+static long max_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char const *argv[]) {
+    const char *baseline = NULL;
+    if (argc == 3 && strcmp(argv[1], "--baseline") == 0)
+    {
+        baseline = argv[2];
+    }
+    else if (argc != 1)
+    {
+        fprintf(stderr, "Usage: %s [--baseline RESULTS]   run from the root of the repository\n", argv[0]);
+        return 2;
+    }
+
+    SudokuBoard *inputs = malloc(MAX_CORPUS_PUZZLES * sizeof(*inputs));
+    SudokuBoard *outputs = malloc(MAX_CORPUS_PUZZLES * sizeof(*outputs));
+    assert(inputs != NULL && outputs != NULL && "Out of memory for puzzles");
+
+    fprintf(stderr, "Solver state: %zu bytes, strategies: %zu, lockstep lanes: %d (%s)\n", sizeof(SudokuSolver),
+            sudoku_default_strategy_count, SUDOKU_LOCKSTEP_LANES, sudoku_lockstep_version());
+    fprintf(stderr, "%-8s %7s %7s %12s %12s %12s %12s %7s %12s %14s %10s\n", "Corpus", "Puzzles", "Solved", "ns/puzzle",
+            "puzzles/s", "Lockstep ns", "Cached ns", "Hits", "No guessing", "Logic ns/puz", "Difficulty");
+
+    SudokuCache cache;
+    const int cache_ready = sudoku_cache_init(&cache, CACHE_CAPACITY);
+    assert(cache_ready && "Out of memory for the solution cache");
+    (void)cache_ready;
+
+    int failed = 0;
+    for (size_t c = 0; c < sizeof(corpora) / sizeof(corpora[0]); c++)
+    {
+        SudokuReader reader;
+        if (!sudoku_reader_open(&reader, corpora[c].path))
+        {
+            perror(corpora[c].path);
+            failed = 1;
+            continue;
+        }
+        const size_t count = sudoku_reader_next_batch(&reader, inputs, MAX_CORPUS_PUZZLES);
+        sudoku_reader_close(&reader);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        CorpusResult result;
+        bench_corpus(&cache, inputs, outputs, count, &result);
+        failed |= result.solved != result.puzzles;
+
+        fprintf(stderr, "%-8s %7zu %7zu %12.0f %12.0f %12.0f %12.0f %6.1f%% %11.1f%% %14.0f %10.2f\n", corpora[c].name,
+                result.puzzles, result.solved, result.ns_per_puzzle, 1e9 / result.ns_per_puzzle,
+                result.lockstep_ns_per_puzzle, result.cache_ns_per_puzzle, 100.0 * result.cache_hit_rate,
+                100.0 * result.logic_solved / result.puzzles,
+                result.logic_ns_per_puzzle, result.mean_difficulty);
+        printf("{\"corpus\":\"%s\",\"puzzles\":%zu,\"solved\":%zu,\"ns_per_puzzle\":%.1f,\"puzzles_per_second\":%.1f,"
+               "\"lockstep_ns_per_puzzle\":%.1f,\"cache_ns_per_puzzle\":%.1f,\"cache_hit_rate\":%.4f,\"logic_solved\":%zu,\"logic_ns_per_puzzle\":%.1f,\"mean_difficulty\":%.3f,"
+               "\"solver_bytes\":%zu,\"max_rss_kb\":%ld}\n",
+               corpora[c].name, result.puzzles, result.solved, result.ns_per_puzzle, 1e9 / result.ns_per_puzzle,
+               result.lockstep_ns_per_puzzle, result.cache_ns_per_puzzle, result.cache_hit_rate, result.logic_solved, result.logic_ns_per_puzzle, result.mean_difficulty,
+               sizeof(SudokuSolver), max_rss_kb());
+        fflush(stdout);
+
+        double before, logic_before;
+        if (baseline != NULL && find_baseline(baseline, corpora[c].name, &before, &logic_before))
+        {
+            fprintf(stderr, "%-8s vs baseline: fast path %+.1f%%, strategies %+.1f%% (time per puzzle)\n", "",
+                    100.0 * (result.ns_per_puzzle - before) / before,
+                    100.0 * (result.logic_ns_per_puzzle - logic_before) / logic_before);
+        }
+    }
+
+    SudokuGrid *grid_puzzles = malloc(MAX_GRID_CORPUS_PUZZLES * sizeof(*grid_puzzles));
+    SudokuGrid *grid_solutions = malloc(MAX_GRID_CORPUS_PUZZLES * sizeof(*grid_solutions));
+    assert(grid_puzzles != NULL && grid_solutions != NULL && "Out of memory for puzzles");
+    for (size_t c = 0; c < sizeof(grid_corpora) / sizeof(grid_corpora[0]); c++)
+    {
+        CorpusResult result;
+        if (!bench_grid_corpus(grid_corpora[c].path, grid_puzzles, grid_solutions, &result))
+        {
+            perror(grid_corpora[c].path);
+            failed = 1;
+            continue;
+        }
+        if (result.puzzles == 0)
+        {
+            continue;
+        }
+        failed |= result.solved != result.puzzles;
+
+        fprintf(stderr, "%-8s %7zu %7zu %12.0f %12.0f\n", grid_corpora[c].name, result.puzzles, result.solved,
+                result.ns_per_puzzle, 1e9 / result.ns_per_puzzle);
+        printf("{\"corpus\":\"%s\",\"puzzles\":%zu,\"solved\":%zu,\"ns_per_puzzle\":%.1f,\"puzzles_per_second\":%.1f,"
+               "\"max_rss_kb\":%ld}\n",
+               grid_corpora[c].name, result.puzzles, result.solved, result.ns_per_puzzle, 1e9 / result.ns_per_puzzle,
+               max_rss_kb());
+        fflush(stdout);
+
+        double before, logic_before;
+        if (baseline != NULL && find_baseline(baseline, grid_corpora[c].name, &before, &logic_before))
+        {
+            fprintf(stderr, "%-8s vs baseline: %+.1f%% (time per puzzle)\n", "",
+                    100.0 * (result.ns_per_puzzle - before) / before);
+        }
+    }
+
+    // 1, 2, 4... threads up to one per core, and at least 2 so the parallel search always runs
+    const unsigned int cores = sudoku_batch_default_threads();
+    double *best_ns = malloc(MAX_GRID_CORPUS_PUZZLES * sizeof(*best_ns));
+    assert(best_ns != NULL && "Out of memory for latencies");
+    fprintf(stderr, "\nSingle puzzle latency (%u cores)\n%-10s %7s %7s %7s %12s %12s %8s\n", cores, "Corpus", "Threads",
+            "Puzzles", "Solved", "Mean ns", "Worst ns", "Speedup");
+    for (size_t c = 0; c < sizeof(latency_corpora) / sizeof(latency_corpora[0]); c++)
+    {
+        SudokuReader reader;
+        if (!sudoku_reader_open(&reader, latency_corpora[c].path))
+        {
+            perror(latency_corpora[c].path);
+            failed = 1;
+            continue;
+        }
+        size_t count = 0;
+        while (count < MAX_GRID_CORPUS_PUZZLES && sudoku_reader_next_grid(&reader, &grid_puzzles[count]))
+        {
+            count++;
+        }
+        sudoku_reader_close(&reader);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        double single_thread_ns = 0;
+        for (unsigned int threads = 1; ; threads = threads * 2 < cores || threads < 2 ? threads * 2 : cores)
+        {
+            LatencyResult result;
+            time_latency(grid_puzzles, grid_solutions, best_ns, count, threads, &result);
+            failed |= result.solved != result.puzzles;
+            single_thread_ns = threads == 1 ? result.worst_ns : single_thread_ns;
+
+            fprintf(stderr, "%-10s %7u %7zu %7zu %12.0f %12.0f %7.2fx\n", latency_corpora[c].name, threads,
+                    result.puzzles, result.solved, result.mean_ns, result.worst_ns, single_thread_ns / result.worst_ns);
+            printf("{\"latency\":\"%s\",\"threads\":%u,\"puzzles\":%zu,\"solved\":%zu,\"mean_ns\":%.1f,"
+                   "\"worst_ns\":%.1f,\"worst_speedup\":%.3f}\n",
+                   latency_corpora[c].name, threads, result.puzzles, result.solved, result.mean_ns, result.worst_ns,
+                   single_thread_ns / result.worst_ns);
+            fflush(stdout);
+            if (threads >= cores && threads >= 2)
+            {
+                break;
+            }
+        }
+    }
+    free(best_ns);
+
+    fprintf(stderr, "Peak memory: %ld KiB\n", max_rss_kb());
+    sudoku_cache_destroy(&cache);
+    free(grid_solutions);
+    free(grid_puzzles);
+    free(outputs);
+    free(inputs);
+
+    // Any puzzle left unsolved is a bug in the solver, not a slow run
+    return failed;
+}
@@ -1,28 +1,877 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
-#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <assert.h>
 #include "example_sudokus.h"
 #include "sudoku_util.h"
 #include "sudoku_solver.h"
+#include "sudoku_batch.h"
+#include "sudoku_io.h"
+#include "sudoku_trace.h"
+#include "sudoku_generator.h"
+#include "sudoku_grid.h"
+#include "sudoku_count.h"
+#include "sudoku_server.h"
+#include "sudoku_corpus.h"
+#include "sudoku_session.h"
+#include "sudoku_variant.h"
 
 unsigned short int sudoku_board[9][9] = {0};
 
-int main(int argc, char const *argv[])
-{
-    assert(argc == 1 && "Not supported command line arguments");
-    assert(argv[1] == 0 && "Not supported command line arguments");
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s                               solve the example sudoku\n", program);
+    fprintf(stderr, "       %s --batch [FILE] [--threads N]   solve one puzzle per line of FILE (or stdin)\n", program);
+    fprintf(stderr, "       %s --count [FILE] [--limit N] [--threads N] [--minimal] [--print]\n", program);
+    fprintf(stderr, "                                         count the solutions of every puzzle, up to N (2 by default),\n");
+    fprintf(stderr, "                                         with --minimal tell whether every clue is needed, and with\n");
+    fprintf(stderr, "                                         --print list the solutions, each before its puzzle line\n");
+    fprintf(stderr, "       %s --serve SOCKET [--threads N]      solve requests sent to the Unix socket SOCKET until stopped,\n", program);
+    fprintf(stderr, "                                         see sudoku_server.h for the protocol\n");
+    fprintf(stderr, "       %s --query SOCKET [FILE] [--count] [--window N]\n", program);
+    fprintf(stderr, "                                         send one puzzle per line of FILE (or stdin) to the daemon at\n");
+    fprintf(stderr, "                                         SOCKET, N requests in flight at a time (64 by default)\n");
+    fprintf(stderr, "       %s --pack [FILE] --output CORPUS [--solutions] [--difficulty] [--threads N]\n", program);
+    fprintf(stderr, "                                         store one puzzle per line of FILE (or stdin) in a binary\n");
+    fprintf(stderr, "                                         corpus, with their solutions and difficulty if asked for\n");
+    fprintf(stderr, "       %s --unpack CORPUS [--solutions] [--first K] [--count N]\n", program);
+    fprintf(stderr, "                                         print N puzzles (or solutions) of CORPUS from the K-th on\n");
+    fprintf(stderr, "       %s --play [PUZZLE]                play PUZZLE (one line, the example sudoku if missing) with\n", program);
+    fprintf(stderr, "                                         commands from stdin, `help` lists them\n");
+    fprintf(stderr, "       %s --grid [FILE] [--threads N]    solve puzzles of any size from 4x4 to 25x25, one per line,\n", program);
+    fprintf(stderr, "                                         each one searched by N threads (0 for one per core)\n");
+    fprintf(stderr, "       %s --variant LAYOUT [FILE] [--count] solve (or count the solutions of) variant puzzles, LAYOUT is\n", program);
+    fprintf(stderr, "                                         x, windoku, jigsaw=REGIONS or killer=CAGES:SUMS, joined by +,\n");
+    fprintf(stderr, "                                         see sudoku_variant.h\n");
+    fprintf(stderr, "       %s --grade [FILE]                 rate the difficulty of one puzzle per line of FILE (or stdin)\n", program);
+    fprintf(stderr, "       %s --generate N [--threads N] [--seed S] [--difficulty LEVEL] [--symmetric]\n", program);
+    fprintf(stderr, "                                         print N puzzles with a unique solution, LEVEL is one of\n");
+    fprintf(stderr, "                                         easy, medium, hard, expert, diabolical\n");
+}
+
+// Puzzles are read, solved and written this many at a time, so inputs of any size run in constant memory
+#define BATCH_CHUNK_PUZZLES 65536
+
+static double seconds_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int run_batch(const char *path, unsigned int threads) {
+    SudokuReader reader;
+    SudokuWriter writer;
+    if (!sudoku_reader_open(&reader, path))
+    {
+        perror(path);
+        return 1;
+    }
+    sudoku_writer_open(&writer, NULL);
+
+    SudokuBoard *inputs = malloc(BATCH_CHUNK_PUZZLES * sizeof(*inputs));
+    SudokuBoard *outputs = malloc(BATCH_CHUNK_PUZZLES * sizeof(*outputs));
+    assert(inputs != NULL && outputs != NULL && "Out of memory for puzzles");
+
+    SudokuBatchStats total, chunk;
+    sudoku_batch_stats_init(&total);
+    const double start = seconds_now();
+
+    size_t count;
+    while ((count = sudoku_reader_next_batch(&reader, inputs, BATCH_CHUNK_PUZZLES)) > 0)
+    {
+        sudoku_batch_solve(inputs, outputs, NULL, count, threads, &chunk);
+        sudoku_batch_stats_merge(&total, &chunk);
+
+        for (size_t k = 0; k < count; k++)
+        {
+            sudoku_writer_put(&writer, outputs[k]);
+        }
+    }
+
+    const int written = sudoku_writer_close(&writer);
+    sudoku_reader_close(&reader);
+    free(outputs);
+    free(inputs);
+
+    sudoku_batch_print_stats(stderr, &total);
+    fprintf(stderr, "Total with reading and writing: %.3f s\n", seconds_now() - start);
 
+    if (!written)
+    {
+        perror("Writing solutions");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Prints one solution as its own line. A single call per line, so the lines of several threads never mix
+ */
+static int print_solution(unsigned short int solution[9][9], void *context) {
+    (void)context;
+    char line[82];
+    format_sudoku_line(solution, line);
+    line[81] = '\0';
+    printf("%s\n", line);
+    return 1;
+}
+
+/*
+ * Prints every puzzle with its number of solutions, followed by `+` when counting stopped at `limit`,
+ * and with `minimal` or `not-minimal` if `check_minimal` is set, which takes a `limit` of at least 2. With `list`
+ * the solutions are listed too, one line each, before the line of their puzzle
+ */
+static int run_count(const char *path, unsigned long long limit, unsigned int threads, int check_minimal, int list) {
+    SudokuReader reader;
+    if (!sudoku_reader_open(&reader, path))
+    {
+        perror(path);
+        return 1;
+    }
+
+    unsigned short int board[9][9];
+    char line[82];
+    line[81] = '\0';
+    size_t puzzles = 0, unique = 0;
+    const double start = seconds_now();
+    while (sudoku_reader_next(&reader, board))
+    {
+        const unsigned long long solutions = list ? sudoku_enumerate_solutions(board, limit, threads, print_solution, NULL)
+                                                  : sudoku_count_solutions(board, limit, threads);
+        // Below a limit of 2, a count of 1 may have stopped before a second solution
+        const int is_unique = limit > 1 && solutions == 1;
+        unique += is_unique;
+        puzzles++;
+
+        format_sudoku_line(board, line);
+        printf("%s %llu%s", line, solutions, solutions == limit ? "+" : "");
+        if (check_minimal)
+        {
+            printf(" %s", is_unique && sudoku_is_minimal(board, threads) ? "minimal" : "not-minimal");
+        }
+        printf("\n");
+    }
+    sudoku_reader_close(&reader);
+
+    if (limit > 1)
+    {
+        fprintf(stderr, "Counted %zu puzzles (%zu with a unique solution) in %.3f s\n", puzzles, unique,
+                seconds_now() - start);
+    }
+    else
+    {
+        fprintf(stderr, "Counted %zu puzzles in %.3f s\n", puzzles, seconds_now() - start);
+    }
+    return 0;
+}
+
+static int run_serve(const char *path, unsigned int threads) {
+    SudokuBatchStats stats;
+    fprintf(stderr, "Listening on %s\n", path);
+    if (!sudoku_server_run(path, threads, &stats))
+    {
+        perror(path);
+        return 1;
+    }
+    sudoku_batch_print_stats(stderr, &stats);
+    return 0;
+}
+
+static int run_query(const char *path, const char *input, int count, size_t window) {
+    SudokuBatchStats stats;
+    const int ok = sudoku_server_query(path, input, count, window, &stats);
+    fflush(stdout);
+    if (!ok)
+    {
+        perror(path);
+    }
+    // Solved means answered with `ok` here, and the latencies are round trips
+    sudoku_batch_print_stats(stderr, &stats);
+    return ok ? 0 : 1;
+}
+
+/*
+ * Converts puzzles from the one-line format into a binary corpus with the columns of `flags` (see sudoku_corpus.h)
+ * Solutions are found on `threads` threads, difficulties by grading one puzzle at a time, which also solves them
+ */
+static int run_pack(const char *input, const char *output, unsigned int flags, unsigned int threads) {
+    SudokuReader reader;
+    SudokuCorpusWriter writer;
+    if (!sudoku_reader_open(&reader, input))
+    {
+        perror(input);
+        return 1;
+    }
+    if (!sudoku_corpus_create(&writer, output, flags))
+    {
+        perror(output);
+        sudoku_reader_close(&reader);
+        return 1;
+    }
+
+    SudokuBoard *puzzles = malloc(BATCH_CHUNK_PUZZLES * sizeof(*puzzles));
+    SudokuBoard *solutions = malloc(BATCH_CHUNK_PUZZLES * sizeof(*solutions));
+    assert(puzzles != NULL && solutions != NULL && "Out of memory for puzzles");
+    SudokuSolver solver;
+    SudokuTrace trace;
+    size_t skipped = 0;
+    const double start = seconds_now();
+
+    size_t count;
+    while ((count = sudoku_reader_next_batch(&reader, puzzles, BATCH_CHUNK_PUZZLES)) > 0)
+    {
+        if ((flags & SUDOKU_CORPUS_SOLUTIONS) && !(flags & SUDOKU_CORPUS_DIFFICULTY))
+        {
+            sudoku_batch_solve(puzzles, solutions, NULL, count, threads, NULL);
+        }
+        for (size_t k = 0; k < count; k++)
+        {
+            double difficulty = -1;
+            if (flags & SUDOKU_CORPUS_DIFFICULTY)
+            {
+                difficulty = sudoku_solver_grade(&solver, &trace, puzzles[k], solutions[k]);
+            }
+            // Puzzles without a solution have nothing to store in the solution column
+            skipped += !sudoku_corpus_append(&writer, puzzles[k], solutions[k], difficulty);
+        }
+    }
+
+    const size_t packed = writer.count;
+    const int written = sudoku_corpus_finish(&writer);
+    sudoku_reader_close(&reader);
+    free(solutions);
+    free(puzzles);
+
+    fprintf(stderr, "Packed %zu puzzles (%zu bytes each, %zu skipped without a solution) in %.3f s\n", packed,
+            sudoku_corpus_record_size(flags), skipped, seconds_now() - start);
+    if (!written)
+    {
+        perror(output);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Prints records [first, first + count) of a binary corpus in the one-line format, their puzzles or their solutions
+ */
+static int run_unpack(const char *path, size_t first, size_t count, int solutions) {
+    SudokuCorpus corpus;
+    if (!sudoku_corpus_open(&corpus, path))
+    {
+        fprintf(stderr, "%s: not a sudoku corpus\n", path);
+        return 1;
+    }
+    if (solutions && !(corpus.flags & SUDOKU_CORPUS_SOLUTIONS))
+    {
+        fprintf(stderr, "%s: has no solutions\n", path);
+        sudoku_corpus_close(&corpus);
+        return 1;
+    }
+
+    SudokuWriter writer;
+    sudoku_writer_open(&writer, NULL);
+    unsigned short int puzzle[9][9], solution[9][9];
+    for (size_t k = first; k - first < count && sudoku_corpus_get(&corpus, k, puzzle, solution, NULL); k++)
+    {
+        sudoku_writer_put(&writer, solutions ? solution : puzzle);
+    }
+
+    const int written = sudoku_writer_close(&writer);
+    sudoku_corpus_close(&corpus);
+    if (!written)
+    {
+        perror("Writing puzzles");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Solves one puzzle of any supported size per line, and prints their solutions in the same format
+ * Puzzles without a solution are printed as far as they got, with the count of them on stderr
+ * With more than one thread (0 for one per core) every puzzle is searched by all of them, for single hard boards
+ */
+static int run_grid(const char *path, unsigned int threads) {
+    SudokuReader reader;
+    SudokuWriter writer;
+    if (!sudoku_reader_open(&reader, path))
+    {
+        perror(path);
+        return 1;
+    }
+    sudoku_writer_open(&writer, NULL);
+
+    SudokuGrid puzzle, solution;
+    size_t puzzles = 0, unsolved = 0;
+    const double start = seconds_now();
+    while (sudoku_reader_next_grid(&reader, &puzzle))
+    {
+        unsolved += threads == 1 ? !sudoku_grid_solve(&puzzle, &solution)
+                                 : !sudoku_grid_solve_parallel(&puzzle, &solution, threads);
+        puzzles++;
+        sudoku_writer_put_grid(&writer, &solution);
+    }
+
+    const int written = sudoku_writer_close(&writer);
+    sudoku_reader_close(&reader);
+    fprintf(stderr, "Solved %zu/%zu puzzles in %.3f s\n", puzzles - unsolved, puzzles, seconds_now() - start);
+
+    if (!written)
+    {
+        perror("Writing solutions");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Solves every puzzle on the layout of `spec`, or with `count` prints each puzzle with its number of solutions
+ * (up to 2, enough to tell whether it is proper)
+ */
+static int run_variant(const char *spec, const char *path, int count) {
+    SudokuTopology topology;
+    if (!sudoku_topology_parse(&topology, spec))
+    {
+        fprintf(stderr, "Invalid layout: %s\n", spec);
+        return 2;
+    }
+    SudokuReader reader;
+    SudokuWriter writer;
+    if (!sudoku_reader_open(&reader, path))
+    {
+        perror(path);
+        return 1;
+    }
+    sudoku_writer_open(&writer, NULL);
+
+    SudokuVariantSolver solver;
+    unsigned short int board[9][9], solution[9][9];
+    char line[82];
+    line[81] = '\0';
+    size_t puzzles = 0, unsolved = 0, unique = 0;
+    const double start = seconds_now();
+    while (sudoku_reader_next(&reader, board))
+    {
+        puzzles++;
+        if (count)
+        {
+            const unsigned int solutions = sudoku_variant_count_solutions(&solver, &topology, board, 2);
+            unique += solutions == 1;
+            format_sudoku_line(board, line);
+            printf("%s %u%s\n", line, solutions, solutions == 2 ? "+" : "");
+            continue;
+        }
+        unsolved += !sudoku_variant_solve(&solver, &topology, board, solution);
+        sudoku_writer_put(&writer, solution);
+    }
+
+    const int written = sudoku_writer_close(&writer);
+    sudoku_reader_close(&reader);
+    if (count)
+    {
+        fprintf(stderr, "Counted %zu puzzles (%zu with a unique solution) in %.3f s\n", puzzles, unique, seconds_now() - start);
+    }
+    else
+    {
+        fprintf(stderr, "Solved %zu/%zu puzzles in %.3f s\n", puzzles - unsolved, puzzles, seconds_now() - start);
+    }
+
+    if (!written)
+    {
+        perror("Writing solutions");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Prints every puzzle with its difficulty and label, and the techniques used over all of them on stderr
+ */
+static int run_grade(const char *path) {
+    SudokuReader reader;
+    if (!sudoku_reader_open(&reader, path))
+    {
+        perror(path);
+        return 1;
+    }
+
+    SudokuSolver solver;
+    SudokuTrace trace, total;
+    sudoku_trace_init(&total);
+    unsigned short int board[9][9], solved[9][9];
+    char line[82];
+    line[81] = '\0';
+    size_t puzzles = 0;
+
+    while (sudoku_reader_next(&reader, board))
+    {
+        const double difficulty = sudoku_solver_grade(&solver, &trace, board, solved);
+        sudoku_trace_merge(&total, &trace);
+        puzzles++;
+
+        format_sudoku_line(board, line);
+        if (difficulty < 0)
+        {
+            printf("%s - Invalid\n", line);
+        }
+        else
+        {
+            printf("%s %.1f %s\n", line, difficulty, sudoku_difficulty_label(difficulty));
+        }
+    }
+    sudoku_reader_close(&reader);
+
+    fprintf(stderr, "Graded %zu puzzles\n", puzzles);
+    sudoku_trace_print(stderr, &total);
+    return 0;
+}
+
+static int run_generate(size_t count, unsigned int threads, const SudokuGeneratorOptions *options) {
+    SudokuWriter writer;
+    sudoku_writer_open(&writer, NULL);
+    SudokuBoard *puzzles = malloc(BATCH_CHUNK_PUZZLES * sizeof(*puzzles));
+    assert(puzzles != NULL && "Out of memory for puzzles");
+
+    const double start = seconds_now();
+    size_t generated = 0;
+    for (size_t first = 0; first < count; first += BATCH_CHUNK_PUZZLES)
+    {
+        const size_t chunk = count - first < BATCH_CHUNK_PUZZLES ? count - first : BATCH_CHUNK_PUZZLES;
+        generated += sudoku_generate_batch(options, first, puzzles, NULL, chunk, threads);
+        for (size_t k = 0; k < chunk; k++)
+        {
+            sudoku_writer_put(&writer, puzzles[k]);
+        }
+    }
+    const double seconds = seconds_now() - start;
+
+    const int written = sudoku_writer_close(&writer);
+    free(puzzles);
+
+    fprintf(stderr, "Generated %zu puzzles (%zu tried) in %.3f s on %u threads (%.0f puzzles/s)\n", count, generated,
+            seconds, threads != 0 ? threads : sudoku_batch_default_threads(), count / seconds);
+    if (!written)
+    {
+        perror("Writing puzzles");
+        return 1;
+    }
+    return 0;
+}
+
+static const char *move_status_text(SudokuMoveStatus status) {
+    switch (status)
+    {
+        case SUDOKU_MOVE_OK: return "ok";
+        case SUDOKU_MOVE_CONFLICT: return "conflict";
+        default: return "rejected";
+    }
+}
+
+static void print_play_help() {
+    printf("R C V      put V in row R, column C (1-9), or empty the cell if V is 0\n");
+    printf("m R C V    add or remove V from the pencil marks of the cell\n");
+    printf("c R C      candidates of the cell\n");
+    printf("u / r      undo / redo\n");
+    printf("h          hint\n");
+    printf("p          print the board\n");
+    printf("q          quit\n");
+}
+
+/*
+ * Interactive game on `puzzle`, one command per line of stdin
+ */
+static int run_play(unsigned short int puzzle[9][9]) {
+    SudokuSession session;
+    if (!sudoku_session_init(&session, puzzle))
+    {
+        fprintf(stderr, "This puzzle has no solution\n");
+        return 1;
+    }
+
+    unsigned short int board[9][9];
+    sudoku_session_board(&session, board);
+    print_sudoku(board);
+    print_play_help();
+
+    char line[256];
+    while (!sudoku_session_is_solved(&session) && fgets(line, sizeof(line), stdin) != NULL)
+    {
+        unsigned int row, column, value;
+        SudokuHint hint;
+        if (sscanf(line, "%u %u %u", &row, &column, &value) == 3)
+        {
+            printf("%s\n", move_status_text(sudoku_session_place(&session, row - 1, column - 1, value)));
+        }
+        else if (sscanf(line, "m %u %u %u", &row, &column, &value) == 3)
+        {
+            printf("%s\n", move_status_text(sudoku_session_toggle_mark(&session, row - 1, column - 1, value)));
+        }
+        else if (sscanf(line, "c %u %u", &row, &column) == 2 && row >= 1 && row <= 9 && column >= 1 && column <= 9)
+        {
+            for (Notes values = sudoku_session_candidates(&session, row - 1, column - 1); values != 0; values &= values - 1)
+            {
+                printf("%d ", __builtin_ctz(values) + 1);
+            }
+            printf("\n");
+        }
+        else if (line[0] == 'u' || line[0] == 'r')
+        {
+            const int done = line[0] == 'u' ? sudoku_session_undo(&session) : sudoku_session_redo(&session);
+            printf("%s\n", done ? "ok" : "nothing to do");
+        }
+        else if (line[0] == 'h' && (hint = sudoku_session_hint(&session)).kind == SUDOKU_HINT_MISTAKE)
+        {
+            printf("%d at row %d, column %d is wrong\n", hint.value, hint.row + 1, hint.column + 1);
+        }
+        else if (line[0] == 'h' && hint.kind == SUDOKU_HINT_PLACE)
+        {
+            printf("%s: %d at row %d, column %d\n", sudoku_technique_name(hint.technique), hint.value, hint.row + 1,
+                   hint.column + 1);
+        }
+        else if (line[0] == 'h')
+        {
+            printf("No value can be found without guessing\n");
+        }
+        else if (line[0] == 'p')
+        {
+            sudoku_session_board(&session, board);
+            print_sudoku(board);
+        }
+        else if (line[0] == 'q')
+        {
+            break;
+        }
+        else
+        {
+            print_play_help();
+        }
+    }
+
+    if (sudoku_session_is_solved(&session))
+    {
+        sudoku_session_board(&session, board);
+        print_sudoku(board);
+        // Moves still on the board, pencil marks aside
+        size_t moves = 0;
+        for (size_t k = 0; k < session.journal_position; k++)
+        {
+            moves += !session.journal[k].is_mark;
+        }
+        printf("Solved in %zu moves\n", moves);
+    }
+    sudoku_session_destroy(&session);
+    return 0;
+}
+
+static int run_example() {
     printf("Trying to solve this sudoku:\n");
     print_sudoku(med1);
     unsigned short int solved[9][9] = {0};
     solve_sudoku(med1, solved);
-    sleep(1);
     printf("\nResult after solve attempt:\n");
     print_sudoku(solved);
-    
-    sleep(1);
+
     printf("\nCompare with real solution:\n");
     print_sudoku(med1_sol);
     
     return 0;
 }
+
+int main(int argc, char const *argv[])
+{
+    if (argc == 1)
+    {
+        return run_example();
+    }
+
+    if (strcmp(argv[1], "--batch") == 0)
+    {
+        const char *path = NULL;
+        unsigned int threads = 0;
+
+        for (int k = 2; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc)
+            {
+                threads = (unsigned int)strtoul(argv[++k], NULL, 10);
+            }
+            else if (path == NULL)
+            {
+                path = argv[k];
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        return run_batch(path, threads);
+    }
+
+    if (strcmp(argv[1], "--generate") == 0 && argc >= 3)
+    {
+        const size_t count = strtoull(argv[2], NULL, 10);
+        unsigned int threads = 0;
+        SudokuGeneratorOptions options;
+        sudoku_generator_default_options(&options);
+
+        for (int k = 3; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc)
+            {
+                threads = (unsigned int)strtoul(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--seed") == 0 && k + 1 < argc)
+            {
+                options.seed = strtoull(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--difficulty") == 0 && k + 1 < argc
+                     && sudoku_difficulty_range(argv[k + 1], &options.min_difficulty, &options.max_difficulty))
+            {
+                k++;
+            }
+            else if (strcmp(argv[k], "--symmetric") == 0)
+            {
+                options.symmetric = 1;
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        return run_generate(count, threads, &options);
+    }
+
+    if (strcmp(argv[1], "--count") == 0)
+    {
+        const char *path = NULL;
+        unsigned long long limit = 2;
+        unsigned int threads = 0;
+        int check_minimal = 0, list = 0;
+
+        for (int k = 2; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc)
+            {
+                threads = (unsigned int)strtoul(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--limit") == 0 && k + 1 < argc)
+            {
+                limit = strtoull(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--minimal") == 0)
+            {
+                check_minimal = 1;
+            }
+            else if (strcmp(argv[k], "--print") == 0)
+            {
+                list = 1;
+            }
+            else if (path == NULL)
+            {
+                path = argv[k];
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        // Telling a minimal puzzle needs to know that it has a single solution, which takes a limit of 2
+        if (check_minimal && limit < 2)
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+        return run_count(path, limit, threads, check_minimal, list);
+    }
+
+    if (strcmp(argv[1], "--serve") == 0 && argc >= 3)
+    {
+        unsigned int threads = 0;
+        for (int k = 3; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc)
+            {
+                threads = (unsigned int)strtoul(argv[++k], NULL, 10);
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        return run_serve(argv[2], threads);
+    }
+
+    if (strcmp(argv[1], "--query") == 0 && argc >= 3)
+    {
+        const char *input = NULL;
+        size_t window = 64;
+        int count = 0;
+
+        for (int k = 3; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--window") == 0 && k + 1 < argc)
+            {
+                window = strtoull(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--count") == 0)
+            {
+                count = 1;
+            }
+            else if (input == NULL)
+            {
+                input = argv[k];
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        return run_query(argv[2], input, count, window);
+    }
+
+    if (strcmp(argv[1], "--pack") == 0)
+    {
+        const char *input = NULL, *output = NULL;
+        unsigned int flags = 0, threads = 0;
+
+        for (int k = 2; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--output") == 0 && k + 1 < argc)
+            {
+                output = argv[++k];
+            }
+            else if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc)
+            {
+                threads = (unsigned int)strtoul(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--solutions") == 0)
+            {
+                flags |= SUDOKU_CORPUS_SOLUTIONS;
+            }
+            else if (strcmp(argv[k], "--difficulty") == 0)
+            {
+                flags |= SUDOKU_CORPUS_DIFFICULTY;
+            }
+            else if (input == NULL)
+            {
+                input = argv[k];
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        if (output == NULL)
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+        return run_pack(input, output, flags, threads);
+    }
+
+    if (strcmp(argv[1], "--unpack") == 0 && argc >= 3)
+    {
+        size_t first = 0, count = (size_t)-1;
+        int solutions = 0;
+
+        for (int k = 3; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--first") == 0 && k + 1 < argc)
+            {
+                first = strtoull(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--count") == 0 && k + 1 < argc)
+            {
+                count = strtoull(argv[++k], NULL, 10);
+            }
+            else if (strcmp(argv[k], "--solutions") == 0)
+            {
+                solutions = 1;
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        return run_unpack(argv[2], first, count, solutions);
+    }
+
+    if (strcmp(argv[1], "--play") == 0 && argc <= 3)
+    {
+        unsigned short int puzzle[9][9];
+        if (argc == 2)
+        {
+            memcpy(puzzle, med1, sizeof(puzzle));
+        }
+        else if (strlen(argv[2]) < 81 || !parse_sudoku_line(argv[2], puzzle))
+        {
+            print_usage(argv[0]);
+            return 2;
+        }
+        return run_play(puzzle);
+    }
+
+    if (strcmp(argv[1], "--grid") == 0)
+    {
+        const char *path = NULL;
+        unsigned int threads = 1;
+
+        for (int k = 2; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--threads") == 0 && k + 1 < argc)
+            {
+                threads = (unsigned int)strtoul(argv[++k], NULL, 10);
+            }
+            else if (path == NULL)
+            {
+                path = argv[k];
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        return run_grid(path, threads);
+    }
+
+    if (strcmp(argv[1], "--variant") == 0 && argc >= 3)
+    {
+        const char *path = NULL;
+        int count = 0;
+        for (int k = 3; k < argc; k++)
+        {
+            if (strcmp(argv[k], "--count") == 0)
+            {
+                count = 1;
+            }
+            else if (path == NULL)
+            {
+                path = argv[k];
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+        return run_variant(argv[2], path, count);
+    }
+
+    if (strcmp(argv[1], "--grade") == 0 && argc <= 3)
+    {
+        return run_grade(argc == 3 ? argv[2] : NULL);
+    }
+
+    print_usage(argv[0]);
+    return 2;
+}
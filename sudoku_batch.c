@@ -0,0 +1,275 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sudoku_batch.h"
+#include "sudoku_lockstep.h"
+
+// Workers take this many puzzles from their own queue at once and solve them side by side in the lockstep lanes,
+// so the queue lock is not taken for every puzzle
+#define BATCH_CHUNK SUDOKU_LOCKSTEP_LANES
+
+/*
+ * Puzzles not yet picked up by a worker, as the index range [head, tail) of the batch
+ * The owner takes from the head, thieves take the second half of what is left from the tail
+ */
+typedef struct WorkQueue {
+    pthread_mutex_t lock;
+    size_t head;
+    size_t tail;
+} WorkQueue;
+
+typedef struct BatchJob {
+    SudokuBoard *inputs;
+    SudokuBoard *outputs;
+    unsigned char *solved;
+    WorkQueue *queues;
+    unsigned int threads;
+} BatchJob;
+
+typedef struct BatchWorker {
+    BatchJob *job;
+    unsigned int id;
+    SudokuBatchStats stats;
+} BatchWorker;
+
+static unsigned long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static size_t latency_bucket(unsigned long long ns) {
+    if (ns < 8)
+    {
+        return ns;
+    }
+    const unsigned int exponent = 63 - __builtin_clzll(ns);
+    return (exponent - 2) * 8 + ((ns >> (exponent - 3)) & 7);
+}
+
+// Middle of the range of latencies that fall into `bucket`
+static double latency_bucket_ns(size_t bucket) {
+    if (bucket < 8)
+    {
+        return bucket;
+    }
+    const unsigned int exponent = bucket / 8 + 2;
+    const double low = (double)((8ull + bucket % 8) << (exponent - 3));
+    return low + ((1ull << (exponent - 3)) - 1) / 2.0;
+}
+
+static void record_latency(SudokuBatchStats *stats, unsigned long long ns) {
+    stats->latency_histogram[latency_bucket(ns)]++;
+    if (ns > stats->latency_max_ns)
+    {
+        stats->latency_max_ns = ns;
+    }
+}
+
+static int take_from_own_queue(WorkQueue *queue, size_t *begin, size_t *end) {
+    pthread_mutex_lock(&queue->lock);
+    *begin = queue->head;
+    *end = queue->tail - queue->head > BATCH_CHUNK ? queue->head + BATCH_CHUNK : queue->tail;
+    queue->head = *end;
+    pthread_mutex_unlock(&queue->lock);
+
+    return *begin < *end;
+}
+
+/*
+ * Moves half of the work left in some other worker's queue into the queue of `thief`
+ * Return 0 if every other queue is empty, >0 otherwise
+ */
+static int steal_work(BatchJob *job, unsigned int thief) {
+    for (unsigned int k = 1; k < job->threads; k++)
+    {
+        WorkQueue *victim = &job->queues[(thief + k) % job->threads];
+        size_t begin, end;
+
+        pthread_mutex_lock(&victim->lock);
+        end = victim->tail;
+        begin = end - (victim->tail - victim->head + 1) / 2;
+        victim->tail = begin;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end)
+        {
+            WorkQueue *own = &job->queues[thief];
+            pthread_mutex_lock(&own->lock);
+            own->head = begin;
+            own->tail = end;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *batch_worker_run(void *arg) {
+    BatchWorker *worker = arg;
+    BatchJob *job = worker->job;
+    unsigned char solved[BATCH_CHUNK];
+    unsigned long long finished_ns[BATCH_CHUNK];
+    size_t begin, end;
+
+    do
+    {
+        while (take_from_own_queue(&job->queues[worker->id], &begin, &end))
+        {
+            // Every puzzle of the chunk is timed from the pick up of the chunk to the moment its own lane was done
+            const unsigned long long start = now_ns();
+            const size_t is_solved = sudoku_lockstep_solve(&job->inputs[begin], &job->outputs[begin], solved,
+                                                           finished_ns, end - begin);
+
+            for (size_t k = begin; k < end; k++)
+            {
+                record_latency(&worker->stats, finished_ns[k - begin] - start);
+                if (job->solved != NULL)
+                {
+                    job->solved[k] = solved[k - begin];
+                }
+            }
+            worker->stats.puzzles += end - begin;
+            worker->stats.solved += is_solved;
+        }
+    } while (steal_work(job, worker->id));
+
+    return NULL;
+}
+
+// -- PUBLIC -- //
+void sudoku_batch_stats_init(SudokuBatchStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void sudoku_batch_stats_merge(SudokuBatchStats *total, const SudokuBatchStats *part) {
+    total->puzzles += part->puzzles;
+    total->solved += part->solved;
+    total->seconds += part->seconds;
+    if (part->threads > total->threads)
+    {
+        total->threads = part->threads;
+    }
+    if (part->latency_max_ns > total->latency_max_ns)
+    {
+        total->latency_max_ns = part->latency_max_ns;
+    }
+    for (size_t b = 0; b < SUDOKU_LATENCY_BUCKETS; b++)
+    {
+        total->latency_histogram[b] += part->latency_histogram[b];
+    }
+}
+
+void sudoku_batch_stats_record(SudokuBatchStats *stats, unsigned long long latency_ns, int solved) {
+    stats->puzzles++;
+    stats->solved += solved != 0;
+    record_latency(stats, latency_ns);
+}
+
+double sudoku_batch_latency_percentile_us(const SudokuBatchStats *stats, double percentile) {
+    if (stats->puzzles == 0)
+    {
+        return 0;
+    }
+    if (percentile >= 1.0)
+    {
+        return stats->latency_max_ns / 1000.0;
+    }
+
+    const unsigned long long rank = (unsigned long long)(percentile * (stats->puzzles - 1)) + 1;
+    unsigned long long seen = 0;
+    for (size_t b = 0; b < SUDOKU_LATENCY_BUCKETS; b++)
+    {
+        seen += stats->latency_histogram[b];
+        if (seen >= rank)
+        {
+            const double ns = latency_bucket_ns(b);
+            return (ns < stats->latency_max_ns ? ns : stats->latency_max_ns) / 1000.0;
+        }
+    }
+    return stats->latency_max_ns / 1000.0;
+}
+
+unsigned int sudoku_batch_default_threads() {
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (unsigned int)cores : 1;
+}
+
+size_t sudoku_batch_solve(SudokuBoard *inputs, SudokuBoard *outputs, unsigned char *solved, size_t count,
+                          unsigned int threads, SudokuBatchStats *stats)
+{
+    if (threads == 0)
+    {
+        threads = sudoku_batch_default_threads();
+    }
+
+    BatchJob job = { inputs, outputs, solved, NULL, threads };
+    job.queues = malloc(threads * sizeof(*job.queues));
+    BatchWorker *workers = malloc(threads * sizeof(*workers));
+    pthread_t *thread_ids = malloc(threads * sizeof(*thread_ids));
+    unsigned char *started = calloc(threads, 1);
+    assert(job.queues != NULL && workers != NULL && thread_ids != NULL && started != NULL
+           && "Out of memory for batch bookkeeping");
+
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        pthread_mutex_init(&job.queues[t].lock, NULL);
+        job.queues[t].head = count * t / threads;
+        job.queues[t].tail = count * (t + 1) / threads;
+        workers[t].job = &job;
+        workers[t].id = t;
+        sudoku_batch_stats_init(&workers[t].stats);
+    }
+
+    const unsigned long long start = now_ns();
+
+    // Thread 0 is the calling thread, any worker that fails to start simply has its queue stolen by the others
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        started[t] = pthread_create(&thread_ids[t], NULL, batch_worker_run, &workers[t]) == 0;
+    }
+    batch_worker_run(&workers[0]);
+
+    SudokuBatchStats total;
+    sudoku_batch_stats_init(&total);
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        if (t > 0 && started[t])
+        {
+            pthread_join(thread_ids[t], NULL);
+        }
+        sudoku_batch_stats_merge(&total, &workers[t].stats);
+    }
+    total.threads = threads;
+    total.seconds = (now_ns() - start) / 1e9;
+
+    if (stats != NULL)
+    {
+        *stats = total;
+    }
+
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        pthread_mutex_destroy(&job.queues[t].lock);
+    }
+    free(started);
+    free(thread_ids);
+    free(workers);
+    free(job.queues);
+
+    return total.solved;
+}
+
+void sudoku_batch_print_stats(FILE *stream, const SudokuBatchStats *stats) {
+    fprintf(stream, "Solved %zu/%zu puzzles in %.3f s on %u threads (%.0f puzzles/s)\n",
+            stats->solved, stats->puzzles, stats->seconds, stats->threads,
+            stats->seconds > 0 ? stats->puzzles / stats->seconds : 0);
+    fprintf(stream, "Latency per puzzle: p50 %.2f us, p90 %.2f us, p99 %.2f us, max %.2f us\n",
+            sudoku_batch_latency_percentile_us(stats, 0.50), sudoku_batch_latency_percentile_us(stats, 0.90),
+            sudoku_batch_latency_percentile_us(stats, 0.99), sudoku_batch_latency_percentile_us(stats, 1.0));
+}
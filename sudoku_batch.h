@@ -0,0 +1,63 @@
+#ifndef SUDOKU_BATCH_H
+#define SUDOKU_BATCH_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+typedef unsigned short int SudokuBoard[9][9];
+
+// Latencies are kept in a log-scale histogram, 8 buckets per power of two of nanoseconds (about 12% precision)
+#define SUDOKU_LATENCY_BUCKETS 512
+
+/*
+ * Timings of one or more batch runs
+ * Latencies are measured per puzzle, from the moment a worker picks it up until it is solved. Workers pick puzzles
+ * up a chunk at a time and solve the chunk side by side, so each puzzle is timed from the pick up of its chunk to
+ * the moment its own lane was done.
+ * Only a histogram is kept, so stats of any number of puzzles take the same memory and can be merged
+ */
+typedef struct SudokuBatchStats {
+    size_t puzzles;
+    size_t solved;
+    unsigned int threads;
+    double seconds;
+    unsigned long long latency_max_ns;
+    unsigned long long latency_histogram[SUDOKU_LATENCY_BUCKETS];
+} SudokuBatchStats;
+
+void sudoku_batch_stats_init(SudokuBatchStats *stats);
+
+/*
+ * Adds the puzzles, timings and latencies of `part` to `total`
+ */
+void sudoku_batch_stats_merge(SudokuBatchStats *total, const SudokuBatchStats *part);
+
+/*
+ * Adds one puzzle that took `latency_ns` to `stats`, counted as solved if `solved` is set
+ */
+void sudoku_batch_stats_record(SudokuBatchStats *stats, unsigned long long latency_ns, int solved);
+
+/*
+ * Latency (in microseconds) that `percentile` (0 to 1) of the puzzles did not exceed
+ */
+double sudoku_batch_latency_percentile_us(const SudokuBatchStats *stats, double percentile);
+
+/*
+ * Number of threads used when 0 is passed to `sudoku_batch_solve`, one per online core
+ */
+unsigned int sudoku_batch_default_threads();
+
+/*
+ * Solves `count` boards from `inputs` into `outputs`, spread over `threads` worker threads
+ * Each worker solves the puzzles of its own queue with `sudoku_lockstep_solve`, and steals half of another worker's queue when
+ * it runs out, so a few slow puzzles don't leave the other threads idle.
+ * `outputs[k]` (and `solved[k]`, if not NULL) always belong to `inputs[k]`, whichever thread solved it.
+ * The calling thread is one of the workers, so the batch still completes if some threads cannot be started.
+ * Return the number of boards that were fully solved
+ */
+size_t sudoku_batch_solve(SudokuBoard *inputs, SudokuBoard *outputs, unsigned char *solved, size_t count,
+                       unsigned int threads, SudokuBatchStats *stats);
+
+void sudoku_batch_print_stats(FILE *stream, const SudokuBatchStats *stats);
+
+#endif // SUDOKU_BATCH_H
@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sudoku_cache.h"
+
+static unsigned long long hash_board(unsigned short int board[9][9]) {
+    // FNV-1a
+    unsigned long long hash = 14695981039346656037ull;
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        hash = (hash ^ board[cell / 9][cell % 9]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static void pack_board(unsigned short int board[9][9], unsigned char packed[41]) {
+    memset(packed, 0, 41);
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        packed[cell / 2] |= (unsigned char)(board[cell / 9][cell % 9] << (4 * (cell % 2)));
+    }
+}
+
+static void unpack_board(const unsigned char packed[41], unsigned short int board[9][9]) {
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        board[cell / 9][cell % 9] = (packed[cell / 2] >> (4 * (cell % 2))) & 0xF;
+    }
+}
+
+static SudokuCacheEntry *find_bucket(const SudokuCache *cache, unsigned long long hash) {
+    return &cache->entries[(hash & (cache->buckets - 1)) * SUDOKU_CACHE_WAYS];
+}
+
+// -- PUBLIC -- //
+int sudoku_cache_init(SudokuCache *cache, size_t capacity) {
+    memset(cache, 0, sizeof(*cache));
+    cache->buckets = 1;
+    while (cache->buckets * SUDOKU_CACHE_WAYS < capacity)
+    {
+        cache->buckets *= 2;
+    }
+    cache->entries = calloc(cache->buckets * SUDOKU_CACHE_WAYS, sizeof(*cache->entries));
+    return cache->entries != NULL;
+}
+
+void sudoku_cache_destroy(SudokuCache *cache) {
+    free(cache->entries);
+    memset(cache, 0, sizeof(*cache));
+}
+
+void sudoku_cache_clear(SudokuCache *cache) {
+    memset(cache->entries, 0, cache->buckets * SUDOKU_CACHE_WAYS * sizeof(*cache->entries));
+    cache->clock = 0;
+    cache->lookups = 0;
+    cache->hits = 0;
+    cache->evictions = 0;
+    cache->bypassed = 0;
+}
+
+int sudoku_cache_solve(SudokuCache *cache, SudokuSolver *solver, unsigned short int input[9][9],
+                       unsigned short int output[9][9]) {
+    unsigned short int canonical[9][9];
+    SudokuTransform transform;
+    if (!sudoku_canonicalize(input, canonical, &transform))
+    {
+        cache->bypassed++;
+        return sudoku_solver_solve(solver, input, output);
+    }
+
+    const unsigned long long hash = hash_board(canonical);
+    unsigned char packed[41];
+    pack_board(canonical, packed);
+    SudokuCacheEntry *bucket = find_bucket(cache, hash);
+    cache->lookups++;
+    cache->clock++;
+
+    for (unsigned short int way = 0; way < SUDOKU_CACHE_WAYS; way++)
+    {
+        SudokuCacheEntry *entry = &bucket[way];
+        if (entry->last_used != 0 && entry->hash == hash && memcmp(entry->puzzle, packed, sizeof(packed)) == 0)
+        {
+            unsigned short int solution[9][9];
+            entry->last_used = cache->clock;
+            cache->hits++;
+            unpack_board(entry->solution, solution);
+            sudoku_transform_revert(&transform, solution, output);
+            return 1;
+        }
+    }
+
+    if (!sudoku_solver_solve(solver, input, output))
+    {
+        return 0;
+    }
+
+    SudokuCacheEntry *victim = &bucket[0];
+    for (unsigned short int way = 1; way < SUDOKU_CACHE_WAYS && victim->last_used != 0; way++)
+    {
+        if (bucket[way].last_used < victim->last_used)
+        {
+            victim = &bucket[way];
+        }
+    }
+    cache->evictions += victim->last_used != 0;
+
+    unsigned short int solution[9][9];
+    sudoku_transform_apply(&transform, output, solution);
+    victim->hash = hash;
+    victim->last_used = cache->clock;
+    memcpy(victim->puzzle, packed, sizeof(packed));
+    pack_board(solution, victim->solution);
+    return 1;
+}
+
+double sudoku_cache_hit_rate(const SudokuCache *cache) {
+    return cache->lookups > 0 ? (double)cache->hits / cache->lookups : 0.0;
+}
@@ -0,0 +1,67 @@
+#ifndef SUDOKU_CACHE_H
+#define SUDOKU_CACHE_H
+
+#include <stddef.h>
+#include "sudoku_solver.h"
+#include "sudoku_canonical.h"
+
+// Entries per bucket, the least recently used one of a full bucket makes room for a new solution
+#define SUDOKU_CACHE_WAYS 4
+
+/*
+ * A solution stored in canonical form, digits packed two per byte
+ */
+typedef struct SudokuCacheEntry {
+    unsigned long long hash;
+    // Last lookup or insertion that used it, 0 for a free entry
+    unsigned long long last_used;
+    unsigned char puzzle[41];
+    unsigned char solution[41];
+} SudokuCacheEntry;
+
+/*
+ * Bounded cache of solved puzzles, indexed by the hash of their canonical form (see `sudoku_canonicalize`),
+ * so every copy of a puzzle under the sudoku symmetries hits the same entry.
+ * Not thread safe: use one per thread, or guard it with a lock
+ */
+typedef struct SudokuCache {
+    SudokuCacheEntry *entries;
+    // Number of buckets, a power of two
+    size_t buckets;
+    unsigned long long clock;
+    unsigned long long lookups;
+    unsigned long long hits;
+    unsigned long long evictions;
+    // Puzzles that skipped the cache because they could not be canonicalised quickly
+    unsigned long long bypassed;
+} SudokuCache;
+
+/*
+ * Creates an empty cache with room for at least `capacity` solutions
+ * Return 0 if there is not enough memory, >0 otherwise
+ */
+int sudoku_cache_init(SudokuCache *cache, size_t capacity);
+
+void sudoku_cache_destroy(SudokuCache *cache);
+
+/*
+ * Forgets every solution and resets the statistics
+ */
+void sudoku_cache_clear(SudokuCache *cache);
+
+/*
+ * Solves `input` into `output` with `solver`, unless its canonical form is in `cache`: the stored solution is then
+ * mapped back through the inverse transform, which costs less than solving it, and `solver` is not touched, so its
+ * candidates are only those of a solve on a miss. Puzzles that miss are solved as they are, so their output is
+ * exactly what `sudoku_solver_solve` gives, and stored if they were solved
+ * Return 0 if the board has no solution, >0 otherwise
+ */
+int sudoku_cache_solve(SudokuCache *cache, SudokuSolver *solver, unsigned short int input[9][9],
+                       unsigned short int output[9][9]);
+
+/*
+ * Share of the lookups that found their solution in the cache, 0 before the first lookup
+ */
+double sudoku_cache_hit_rate(const SudokuCache *cache);
+
+#endif // SUDOKU_CACHE_H
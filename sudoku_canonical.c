@@ -0,0 +1,274 @@
+#include <string.h>
+#include "sudoku_canonical.h"
+
+// Orders of three lines (or of three bands), in order of the permutation
+static const unsigned char permutations[6][3] = {
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+};
+
+static unsigned long long pack_sorted(unsigned long long a, unsigned long long b, unsigned long long c, unsigned int bits) {
+    unsigned long long t;
+    if (a > b) { t = a; a = b; b = t; }
+    if (b > c) { t = b; b = c; c = t; }
+    if (a > b) { t = a; a = b; b = t; }
+    return (a << (2 * bits)) | (b << bits) | c;
+}
+
+/*
+ * Invariants of the rows (`transposed` 0) or of the columns (`transposed` 1) of `board`, and of the bands or stacks
+ * they make up. A line is described by its givens and the sum of their `weights` in each of the three boxes it
+ * crosses, sorted, so neither permuting the lines across it nor relabelling changes it
+ */
+static void line_keys(const unsigned char board[81], const unsigned char weights[10], int transposed,
+                      unsigned long long lines[9], unsigned long long groups[3]) {
+    for (unsigned short int line = 0; line < 9; line++)
+    {
+        unsigned long long part[3] = {0, 0, 0};
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            const unsigned char value = board[transposed ? k * 9 + line : line * 9 + k];
+            if (value != 0)
+            {
+                part[k / 3] += 32 + weights[value];
+            }
+        }
+        lines[line] = pack_sorted(part[0], part[1], part[2], 7);
+    }
+    for (unsigned short int group = 0; group < 3; group++)
+    {
+        groups[group] = pack_sorted(lines[group * 3], lines[group * 3 + 1], lines[group * 3 + 2], 21);
+    }
+}
+
+/*
+ * Compares the keys of three groups, each set sorted first
+ * Return <0 if `a` comes first, >0 if `b` does, 0 if they are the same
+ */
+static int compare_sorted(const unsigned long long a[3], const unsigned long long b[3]) {
+    unsigned long long x[3] = {a[0], a[1], a[2]}, y[3] = {b[0], b[1], b[2]};
+    for (unsigned short int i = 0; i < 3; i++)
+    {
+        for (unsigned short int j = i + 1; j < 3; j++)
+        {
+            unsigned long long t;
+            if (x[j] < x[i]) { t = x[i]; x[i] = x[j]; x[j] = t; }
+            if (y[j] < y[i]) { t = y[i]; y[i] = y[j]; y[j] = t; }
+        }
+    }
+    for (unsigned short int i = 0; i < 3; i++)
+    {
+        if (x[i] != y[i])
+        {
+            return x[i] < y[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Writes into `orders` every order of the nine lines that keeps the groups of three together, with the groups
+ * and the lines inside each group in increasing order of their keys, up to `max` orders
+ * Return the number of such orders, which may be more than `max`
+ */
+static size_t line_orders(const unsigned long long lines[9], const unsigned long long groups[3],
+                          unsigned char orders[][9], size_t max) {
+    // Orders inside each group that keep its lines sorted
+    unsigned char inside[3][6];
+    size_t inside_count[3] = {0, 0, 0};
+    for (unsigned short int group = 0; group < 3; group++)
+    {
+        const unsigned long long *keys = &lines[group * 3];
+        for (unsigned short int p = 0; p < 6; p++)
+        {
+            const unsigned char *order = permutations[p];
+            if (keys[order[0]] <= keys[order[1]] && keys[order[1]] <= keys[order[2]])
+            {
+                inside[group][inside_count[group]++] = p;
+            }
+        }
+    }
+
+    size_t count = 0;
+    for (unsigned short int p = 0; p < 6; p++)
+    {
+        const unsigned char *group_order = permutations[p];
+        if (groups[group_order[0]] > groups[group_order[1]] || groups[group_order[1]] > groups[group_order[2]])
+        {
+            continue;
+        }
+        const size_t combinations = inside_count[0] * inside_count[1] * inside_count[2];
+        for (size_t c = 0; c < combinations; c++, count++)
+        {
+            if (count >= max)
+            {
+                continue;
+            }
+            size_t rest = c;
+            for (unsigned short int g = 0; g < 3; g++)
+            {
+                const unsigned short int group = group_order[g];
+                const unsigned char *order = permutations[inside[group][rest % inside_count[group]]];
+                rest /= inside_count[group];
+                for (unsigned short int k = 0; k < 3; k++)
+                {
+                    orders[count][g * 3 + k] = group * 3 + order[k];
+                }
+            }
+        }
+    }
+    return count;
+}
+
+typedef struct Candidate {
+    unsigned char values[81];
+    unsigned char cells[81];
+    unsigned char digits[10];
+} Candidate;
+
+/*
+ * Reads `board` in the order of `rows` and `columns` (swapped if `transposed`) with the digits relabelled in order
+ * of first appearance, and keeps it in `best` if it is smaller. Reading stops as soon as it is bigger
+ */
+static void try_candidate(const unsigned char board[81], const unsigned char rows[9], const unsigned char columns[9],
+                          int transposed, Candidate *best, Candidate *candidate) {
+    memset(candidate->digits, 0, sizeof(candidate->digits));
+    unsigned char next_digit = 1;
+    int smaller = 0;
+    const unsigned short int row_stride = transposed ? 1 : 9, column_stride = transposed ? 9 : 1;
+
+    for (unsigned short int i = 0, k = 0; i < 9; i++)
+    {
+        const unsigned short int row = rows[i] * row_stride;
+        for (unsigned short int j = 0; j < 9; j++, k++)
+        {
+            const unsigned char cell = row + columns[j] * column_stride;
+            const unsigned char value = board[cell];
+            unsigned char label = 0;
+            if (value != 0)
+            {
+                if (candidate->digits[value] == 0)
+                {
+                    candidate->digits[value] = next_digit++;
+                }
+                label = candidate->digits[value];
+            }
+
+            if (!smaller)
+            {
+                if (label > best->values[k])
+                {
+                    return;
+                }
+                smaller = label < best->values[k];
+            }
+            candidate->values[k] = label;
+            candidate->cells[k] = cell;
+        }
+    }
+
+    if (smaller)
+    {
+        *best = *candidate;
+    }
+}
+
+// -- PUBLIC -- //
+int sudoku_canonicalize(unsigned short int board[9][9], unsigned short int canonical[9][9], SudokuTransform *transform) {
+    unsigned char values[81];
+    unsigned char weights[10] = {0};
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const unsigned short int value = board[cell / 9][cell % 9];
+        if (value > 9)
+        {
+            return 0;
+        }
+        values[cell] = (unsigned char)value;
+        weights[value]++;
+    }
+    weights[0] = 0;
+
+    unsigned long long rows[9], bands[3], columns[9], stacks[3];
+    line_keys(values, weights, 0, rows, bands);
+    line_keys(values, weights, 1, columns, stacks);
+
+    // Transposing swaps bands and stacks, so the orientation with the smaller bands is tried, or both if equal
+    const int orientation = compare_sorted(bands, stacks);
+    unsigned char row_orders[SUDOKU_CANONICAL_MAX_CANDIDATES][9];
+    unsigned char column_orders[SUDOKU_CANONICAL_MAX_CANDIDATES][9];
+    Candidate best, candidate;
+    memset(best.values, 0xFF, sizeof(best.values));
+    size_t tried = 0;
+
+    for (int transposed = 0; transposed < 2; transposed++)
+    {
+        if (transposed ? orientation < 0 : orientation > 0)
+        {
+            continue;
+        }
+        // The canonical rows are the original columns when transposed
+        const size_t row_count = line_orders(transposed ? columns : rows, transposed ? stacks : bands, row_orders,
+                                             SUDOKU_CANONICAL_MAX_CANDIDATES);
+        const size_t column_count = line_orders(transposed ? rows : columns, transposed ? bands : stacks, column_orders,
+                                                SUDOKU_CANONICAL_MAX_CANDIDATES);
+        tried += row_count * column_count;
+        if (tried > SUDOKU_CANONICAL_MAX_CANDIDATES)
+        {
+            return 0;
+        }
+
+        for (size_t r = 0; r < row_count; r++)
+        {
+            for (size_t c = 0; c < column_count; c++)
+            {
+                try_candidate(values, row_orders[r], column_orders[c], transposed, &best, &candidate);
+            }
+        }
+    }
+
+    // Digits the board does not use are labelled after the others, in increasing order
+    unsigned char next_digit = 1;
+    for (unsigned short int digit = 1; digit <= 9; digit++)
+    {
+        next_digit += best.digits[digit] != 0;
+    }
+    for (unsigned short int digit = 1; digit <= 9; digit++)
+    {
+        if (best.digits[digit] == 0)
+        {
+            best.digits[digit] = next_digit++;
+        }
+    }
+
+    memcpy(transform->cells, best.cells, sizeof(transform->cells));
+    memcpy(transform->digits, best.digits, sizeof(transform->digits));
+    transform->digits[0] = 0;
+    for (unsigned short int k = 0; k < 81; k++)
+    {
+        canonical[k / 9][k % 9] = best.values[k];
+    }
+    return 1;
+}
+
+void sudoku_transform_apply(const SudokuTransform *transform, unsigned short int board[9][9],
+                            unsigned short int transformed[9][9]) {
+    for (unsigned short int k = 0; k < 81; k++)
+    {
+        const unsigned short int cell = transform->cells[k];
+        transformed[k / 9][k % 9] = transform->digits[board[cell / 9][cell % 9]];
+    }
+}
+
+void sudoku_transform_revert(const SudokuTransform *transform, unsigned short int transformed[9][9],
+                             unsigned short int board[9][9]) {
+    unsigned char original_digit[10] = {0};
+    for (unsigned short int digit = 1; digit <= 9; digit++)
+    {
+        original_digit[transform->digits[digit]] = (unsigned char)digit;
+    }
+    for (unsigned short int k = 0; k < 81; k++)
+    {
+        const unsigned short int cell = transform->cells[k];
+        board[cell / 9][cell % 9] = original_digit[transformed[k / 9][k % 9]];
+    }
+}
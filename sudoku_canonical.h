@@ -0,0 +1,46 @@
+#ifndef SUDOKU_CANONICAL_H
+#define SUDOKU_CANONICAL_H
+
+/*
+ * Canonical form of a board under the symmetries of sudoku: relabelling the digits, permuting the rows inside a band
+ * and the columns inside a stack, permuting the bands and the stacks, and transposing.
+ * Boards that are copies of each other under these get the same canonical form, and the same solutions up to the
+ * same transform, so one solution of the canonical form serves all of them
+ */
+
+/*
+ * Maps a board to its canonical form and back
+ * Canonical cell k shows original cell `cells[k]`, and original digit d is shown as `digits[d]` (0 stays 0)
+ */
+typedef struct SudokuTransform {
+    unsigned char cells[81];
+    unsigned char digits[10];
+} SudokuTransform;
+
+// Boards with more candidate transforms than this to compare are too symmetric to canonicalise quickly
+#define SUDOKU_CANONICAL_MAX_CANDIDATES 1024
+
+/*
+ * Writes the canonical form of `board` into `canonical`, and the transform that leads there into `transform`
+ * The canonical form is the smallest board, read row after row with empty cells as 0, among the transforms that
+ * put the rows, columns, bands and stacks in the order of invariants that no symmetry changes (how many givens they
+ * hold, how they spread over the boxes, how common their digits are). Only the ties of that order are tried.
+ * Digits are relabelled in order of first appearance, and the ones the board does not use after those.
+ * Return 0 if `board` has values out of range or is too symmetric (see SUDOKU_CANONICAL_MAX_CANDIDATES), >0 otherwise
+ */
+int sudoku_canonicalize(unsigned short int board[9][9], unsigned short int canonical[9][9], SudokuTransform *transform);
+
+/*
+ * Applies `transform` to `board`, so a solution of the original board becomes a solution of the canonical one
+ */
+void sudoku_transform_apply(const SudokuTransform *transform, unsigned short int board[9][9],
+                            unsigned short int transformed[9][9]);
+
+/*
+ * Applies the inverse of `transform` to `transformed`, so a solution of the canonical board becomes a solution of
+ * the original one
+ */
+void sudoku_transform_revert(const SudokuTransform *transform, unsigned short int transformed[9][9],
+                             unsigned short int board[9][9]);
+
+#endif // SUDOKU_CANONICAL_H
@@ -0,0 +1,242 @@
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sudoku_corpus.h"
+
+#define CORPUS_MAGIC "SUDOKUBC"
+#define CORPUS_BOARD_SIZE 41
+#define CORPUS_BITMAP_SIZE 11
+#define CORPUS_UNKNOWN_DIFFICULTY 255
+
+static void put_u32(unsigned char *out, unsigned long long value) {
+    for (unsigned short int k = 0; k < 4; k++)
+    {
+        out[k] = (unsigned char)(value >> (8 * k));
+    }
+}
+
+static void put_u64(unsigned char *out, unsigned long long value) {
+    put_u32(out, value & 0xFFFFFFFFull);
+    put_u32(out + 4, value >> 32);
+}
+
+static unsigned long long get_u32(const unsigned char *in) {
+    return (unsigned long long)in[0] | (unsigned long long)in[1] << 8 | (unsigned long long)in[2] << 16
+           | (unsigned long long)in[3] << 24;
+}
+
+static unsigned long long get_u64(const unsigned char *in) {
+    return get_u32(in) | get_u32(in + 4) << 32;
+}
+
+static void write_header(unsigned char header[SUDOKU_CORPUS_HEADER_SIZE], unsigned int flags, size_t count) {
+    memset(header, 0, SUDOKU_CORPUS_HEADER_SIZE);
+    memcpy(header, CORPUS_MAGIC, 8);
+    put_u32(header + 8, SUDOKU_CORPUS_VERSION);
+    put_u32(header + 12, flags);
+    put_u32(header + 16, sudoku_corpus_record_size(flags));
+    put_u64(header + 24, count);
+}
+
+static void pack_board(unsigned short int board[9][9], unsigned char packed[CORPUS_BOARD_SIZE]) {
+    memset(packed, 0, CORPUS_BOARD_SIZE);
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        packed[cell / 2] |= (unsigned char)(board[cell / 9][cell % 9] << (4 * (cell % 2)));
+    }
+}
+
+static void unpack_board(const unsigned char packed[CORPUS_BOARD_SIZE], unsigned short int board[9][9]) {
+    unsigned short int *cells = &board[0][0];
+    for (unsigned short int k = 0; k < 40; k++)
+    {
+        cells[2 * k] = packed[k] & 0xF;
+        cells[2 * k + 1] = packed[k] >> 4;
+    }
+    cells[80] = packed[40] & 0xF;
+}
+
+// -- PUBLIC -- //
+size_t sudoku_corpus_record_size(unsigned int flags) {
+    size_t size = CORPUS_BOARD_SIZE;
+    if (flags & SUDOKU_CORPUS_SOLUTIONS)
+    {
+        size += CORPUS_BITMAP_SIZE;
+    }
+    if (flags & SUDOKU_CORPUS_DIFFICULTY)
+    {
+        size += 1;
+    }
+    return size;
+}
+
+int sudoku_corpus_open(SudokuCorpus *corpus, const char *path) {
+    memset(corpus, 0, sizeof(*corpus));
+    corpus->fd = open(path, O_RDONLY);
+    if (corpus->fd < 0)
+    {
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(corpus->fd, &info) != 0 || info.st_size < SUDOKU_CORPUS_HEADER_SIZE)
+    {
+        sudoku_corpus_close(corpus);
+        return 0;
+    }
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, corpus->fd, 0);
+    if (data == MAP_FAILED)
+    {
+        sudoku_corpus_close(corpus);
+        return 0;
+    }
+    // Records are read in whatever order the caller wants, read-ahead would mostly fetch pages nobody reads
+    madvise(data, info.st_size, MADV_RANDOM);
+    corpus->data = data;
+    corpus->size = info.st_size;
+
+    const unsigned char *header = corpus->data;
+    corpus->flags = (unsigned int)get_u32(header + 12);
+    corpus->record_size = get_u32(header + 16);
+    corpus->count = get_u64(header + 24);
+    if (memcmp(header, CORPUS_MAGIC, 8) != 0 || get_u32(header + 8) != SUDOKU_CORPUS_VERSION
+        || corpus->flags > (SUDOKU_CORPUS_SOLUTIONS | SUDOKU_CORPUS_DIFFICULTY)
+        || corpus->record_size != sudoku_corpus_record_size(corpus->flags)
+        || corpus->count > (corpus->size - SUDOKU_CORPUS_HEADER_SIZE) / corpus->record_size)
+    {
+        sudoku_corpus_close(corpus);
+        return 0;
+    }
+    return 1;
+}
+
+int sudoku_corpus_get(const SudokuCorpus *corpus, size_t index, unsigned short int puzzle[9][9],
+                      unsigned short int solution[9][9], double *difficulty)
+{
+    if (index >= corpus->count)
+    {
+        return 0;
+    }
+    const unsigned char *record = corpus->data + SUDOKU_CORPUS_HEADER_SIZE + index * corpus->record_size;
+
+    if (corpus->flags & SUDOKU_CORPUS_SOLUTIONS)
+    {
+        const unsigned char *givens = record;
+        unpack_board(record + CORPUS_BITMAP_SIZE, puzzle);
+        if (solution != NULL)
+        {
+            memcpy(solution, puzzle, 81 * sizeof(**puzzle));
+        }
+        unsigned short int *cells = &puzzle[0][0];
+        for (unsigned short int cell = 0; cell < 81; cell++)
+        {
+            // Branch free, the givens are as good as random
+            cells[cell] &= -(unsigned short int)(givens[cell / 8] >> (cell % 8) & 1);
+        }
+        record += CORPUS_BITMAP_SIZE + CORPUS_BOARD_SIZE;
+    }
+    else
+    {
+        unpack_board(record, puzzle);
+        if (solution != NULL)
+        {
+            memset(solution, 0, 81 * sizeof(**solution));
+        }
+        record += CORPUS_BOARD_SIZE;
+    }
+
+    if (difficulty != NULL)
+    {
+        *difficulty = -1;
+        if ((corpus->flags & SUDOKU_CORPUS_DIFFICULTY) && *record != CORPUS_UNKNOWN_DIFFICULTY)
+        {
+            *difficulty = *record / 10.0;
+        }
+    }
+    return 1;
+}
+
+void sudoku_corpus_close(SudokuCorpus *corpus) {
+    if (corpus->data != NULL)
+    {
+        munmap((void *)corpus->data, corpus->size);
+    }
+    if (corpus->fd >= 0)
+    {
+        close(corpus->fd);
+    }
+    memset(corpus, 0, sizeof(*corpus));
+    corpus->fd = -1;
+}
+
+int sudoku_corpus_create(SudokuCorpusWriter *writer, const char *path, unsigned int flags) {
+    memset(writer, 0, sizeof(*writer));
+    writer->flags = flags;
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL)
+    {
+        return 0;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, 1 << 20);
+
+    // Rewritten with the number of records by `sudoku_corpus_finish`
+    unsigned char header[SUDOKU_CORPUS_HEADER_SIZE];
+    write_header(header, flags, 0);
+    writer->failed = fwrite(header, sizeof(header), 1, writer->file) != 1;
+    return 1;
+}
+
+int sudoku_corpus_append(SudokuCorpusWriter *writer, unsigned short int puzzle[9][9], unsigned short int solution[9][9],
+                         double difficulty)
+{
+    unsigned char record[CORPUS_BITMAP_SIZE + CORPUS_BOARD_SIZE + 1];
+    size_t size = 0;
+
+    if (writer->flags & SUDOKU_CORPUS_SOLUTIONS)
+    {
+        memset(record, 0, CORPUS_BITMAP_SIZE);
+        for (unsigned short int cell = 0; cell < 81; cell++)
+        {
+            const unsigned short int given = puzzle[cell / 9][cell % 9], value = solution[cell / 9][cell % 9];
+            if (value < 1 || value > 9 || (given != 0 && given != value))
+            {
+                return 0;
+            }
+            record[cell / 8] |= (unsigned char)((given != 0) << (cell % 8));
+        }
+        pack_board(solution, record + CORPUS_BITMAP_SIZE);
+        size = CORPUS_BITMAP_SIZE + CORPUS_BOARD_SIZE;
+    }
+    else
+    {
+        pack_board(puzzle, record);
+        size = CORPUS_BOARD_SIZE;
+    }
+
+    if (writer->flags & SUDOKU_CORPUS_DIFFICULTY)
+    {
+        const double tenths = difficulty * 10 + 0.5;
+        record[size++] = difficulty < 0 ? CORPUS_UNKNOWN_DIFFICULTY
+                         : tenths >= CORPUS_UNKNOWN_DIFFICULTY ? CORPUS_UNKNOWN_DIFFICULTY - 1 : (unsigned char)tenths;
+    }
+
+    writer->failed |= fwrite(record, size, 1, writer->file) != 1;
+    writer->count++;
+    return 1;
+}
+
+int sudoku_corpus_finish(SudokuCorpusWriter *writer) {
+    unsigned char header[SUDOKU_CORPUS_HEADER_SIZE];
+    write_header(header, writer->flags, writer->count);
+    writer->failed |= fseek(writer->file, 0, SEEK_SET) != 0;
+    writer->failed |= fwrite(header, sizeof(header), 1, writer->file) != 1;
+    writer->failed |= fclose(writer->file) != 0;
+
+    const int ok = !writer->failed;
+    memset(writer, 0, sizeof(*writer));
+    return ok;
+}
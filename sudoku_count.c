@@ -0,0 +1,301 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "sudoku_count.h"
+#include "sudoku_batch.h"
+#include "sudoku_solver_internal.h"
+
+// The top of the tree is split until there are this many subtrees per thread, so uneven subtrees even out
+#define SUBTREES_PER_THREAD 8
+// and no deeper than this many guesses, past which the subtrees are small enough to leave whole
+#define MAX_SPLIT_DEPTH 6
+
+typedef struct CountJob {
+    // Boards after some guesses, not propagated yet, taken by the threads in order
+    SudokuSolver *subtrees;
+    size_t subtree_count;
+    size_t next_subtree;
+    unsigned long long limit;
+    // Solutions found by all threads together, including ones past the limit that were not counted
+    unsigned long long total;
+    SudokuSolutionCallback callback;
+    void *context;
+} CountJob;
+
+typedef struct CountWorker {
+    CountJob *job;
+    // Solutions counted by this thread only
+    unsigned long long found;
+} CountWorker;
+
+static int limit_reached(const CountJob *job) {
+    return __atomic_load_n(&job->total, __ATOMIC_RELAXED) >= job->limit;
+}
+
+/*
+ * Takes the next of the `limit` solutions for `worker`, and hands it to the callback
+ */
+static void record_solution(CountWorker *worker, const SudokuSolver *solver) {
+    CountJob *job = worker->job;
+    if (__atomic_fetch_add(&job->total, 1, __ATOMIC_RELAXED) >= job->limit)
+    {
+        return;
+    }
+    worker->found++;
+
+    if (job->callback != NULL)
+    {
+        unsigned short int solution[9][9];
+        for (unsigned short int cell = 0; cell < 81; cell++)
+        {
+            solution[cell / 9][cell % 9] = __builtin_ctz(solver->candidates[cell / 9][cell % 9]) + 1;
+        }
+        if (!job->callback(solution, job->context))
+        {
+            __atomic_store_n(&job->total, job->limit, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void enumerate(CountWorker *worker, SudokuSolver *solver) {
+    if (limit_reached(worker->job) || !propagate_singles(solver))
+    {
+        return;
+    }
+
+    const unsigned short int cell = pick_search_cell(solver);
+    if (cell == 81)
+    {
+        record_solution(worker, solver);
+        return;
+    }
+
+    const unsigned short int i = cell / 9, j = cell % 9;
+    for (Notes options = solver->candidates[i][j]; options != 0 && !limit_reached(worker->job); options &= options - 1)
+    {
+        SudokuSolver guess = *solver;
+        handle_number_in_cell(&guess, __builtin_ctz(options) + 1, i, j);
+        enumerate(worker, &guess);
+    }
+}
+
+static void *count_worker_run(void *arg) {
+    CountWorker *worker = arg;
+    CountJob *job = worker->job;
+    for (;;)
+    {
+        const size_t k = __atomic_fetch_add(&job->next_subtree, 1, __ATOMIC_RELAXED);
+        if (k >= job->subtree_count || limit_reached(job))
+        {
+            break;
+        }
+        enumerate(worker, &job->subtrees[k]);
+    }
+    return NULL;
+}
+
+/*
+ * Replaces the subtrees of `job` by their children, one per candidate of the cell each would guess next.
+ * Dead ends are dropped, and boards already solved are recorded for `worker`
+ * Return 0 if no subtree had children, >0 otherwise
+ */
+static int split_subtrees(CountJob *job, CountWorker *worker) {
+    SudokuSolver *next = malloc(9 * job->subtree_count * sizeof(*next));
+    assert(next != NULL && "Out of memory for subtrees");
+
+    size_t count = 0;
+    int split = 0;
+    for (size_t k = 0; k < job->subtree_count && !limit_reached(job); k++)
+    {
+        SudokuSolver *solver = &job->subtrees[k];
+        if (!propagate_singles(solver))
+        {
+            continue;
+        }
+        const unsigned short int cell = pick_search_cell(solver);
+        if (cell == 81)
+        {
+            record_solution(worker, solver);
+            continue;
+        }
+
+        const unsigned short int i = cell / 9, j = cell % 9;
+        for (Notes options = solver->candidates[i][j]; options != 0; options &= options - 1)
+        {
+            next[count] = *solver;
+            handle_number_in_cell(&next[count++], __builtin_ctz(options) + 1, i, j);
+        }
+        split = 1;
+    }
+
+    free(job->subtrees);
+    job->subtrees = next;
+    job->subtree_count = count;
+    return split;
+}
+
+/*
+ * Runs `run` on `threads` threads, each with its own argument from `args` (`size` bytes apart)
+ * The calling thread is the first of them, so the work completes even if no thread can be started
+ */
+static void run_on_threads(void *(*run)(void *), void *args, size_t size, unsigned int threads) {
+    pthread_t *thread_ids = malloc(threads * sizeof(*thread_ids));
+    unsigned char *started = calloc(threads, 1);
+    assert(thread_ids != NULL && started != NULL && "Out of memory for thread bookkeeping");
+
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        started[t] = pthread_create(&thread_ids[t], NULL, run, (char *)args + t * size) == 0;
+    }
+    run(args);
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(thread_ids[t], NULL);
+        }
+    }
+
+    free(started);
+    free(thread_ids);
+}
+
+typedef struct MinimalJob {
+    unsigned short int (*board)[9];
+    unsigned short int clues[81];
+    size_t clue_count;
+    size_t next_clue;
+    // Set once a clue is found that the puzzle does not need
+    int removable;
+} MinimalJob;
+
+/*
+ * Tells whether the puzzle still has a single solution without the clue at `cell`: it had one with it,
+ * so any other solution has another value there, and one search for such a solution is enough
+ * Return 0 if the clue is needed, >0 otherwise
+ */
+static int is_clue_removable(unsigned short int board[9][9], unsigned short int cell) {
+    unsigned short int without[9][9];
+    memcpy(without, board, sizeof(without));
+    const unsigned short int value = without[cell / 9][cell % 9];
+    without[cell / 9][cell % 9] = 0;
+
+    SudokuSolver solver;
+    sudoku_solver_init(&solver);
+    if (!place_givens(&solver, without))
+    {
+        return 0;
+    }
+    remove_candidate_from_cell(&solver, value, cell / 9, cell % 9);
+    return count_solutions(&solver, 1) == 0;
+}
+
+static void *minimal_worker_run(void *arg) {
+    MinimalJob *job = *(MinimalJob **)arg;
+    for (;;)
+    {
+        const size_t k = __atomic_fetch_add(&job->next_clue, 1, __ATOMIC_RELAXED);
+        if (k >= job->clue_count || __atomic_load_n(&job->removable, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+        if (is_clue_removable(job->board, job->clues[k]))
+        {
+            __atomic_store_n(&job->removable, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+// -- PUBLIC -- //
+unsigned long long sudoku_count_solutions(unsigned short int board[9][9], unsigned long long limit, unsigned int threads) {
+    return sudoku_enumerate_solutions(board, limit, threads, NULL, NULL);
+}
+
+unsigned long long sudoku_enumerate_solutions(unsigned short int board[9][9], unsigned long long limit, unsigned int threads,
+                                              SudokuSolutionCallback callback, void *context)
+{
+    if (threads == 0)
+    {
+        threads = sudoku_batch_default_threads();
+    }
+
+    CountJob job = { NULL, 1, 0, limit, 0, callback, context };
+    job.subtrees = malloc(sizeof(*job.subtrees));
+    assert(job.subtrees != NULL && "Out of memory for subtrees");
+    sudoku_solver_init(&job.subtrees[0]);
+    if (limit == 0 || !place_givens(&job.subtrees[0], board))
+    {
+        free(job.subtrees);
+        return 0;
+    }
+
+    CountWorker *workers = calloc(threads, sizeof(*workers));
+    assert(workers != NULL && "Out of memory for workers");
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        workers[t].job = &job;
+    }
+
+    // Puzzles with a unique solution rarely get past the first split, so they never pay for the threads
+    for (unsigned int depth = 0; threads > 1 && depth < MAX_SPLIT_DEPTH && job.subtree_count > 0
+         && job.subtree_count < (size_t)threads * SUBTREES_PER_THREAD && !limit_reached(&job); depth++)
+    {
+        if (!split_subtrees(&job, &workers[0]))
+        {
+            break;
+        }
+    }
+    if (job.subtree_count > 1)
+    {
+        run_on_threads(count_worker_run, workers, sizeof(*workers), threads);
+    }
+    else
+    {
+        count_worker_run(&workers[0]);
+    }
+
+    unsigned long long found = 0;
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        found += workers[t].found;
+    }
+    free(workers);
+    free(job.subtrees);
+    return found;
+}
+
+int sudoku_is_minimal(unsigned short int board[9][9], unsigned int threads) {
+    if (threads == 0)
+    {
+        threads = sudoku_batch_default_threads();
+    }
+    if (sudoku_count_solutions(board, 2, threads) != 1)
+    {
+        return 0;
+    }
+
+    MinimalJob job;
+    job.board = board;
+    job.clue_count = 0;
+    job.next_clue = 0;
+    job.removable = 0;
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        if (board[cell / 9][cell % 9] != 0)
+        {
+            job.clues[job.clue_count++] = cell;
+        }
+    }
+
+    MinimalJob **args = malloc(threads * sizeof(*args));
+    assert(args != NULL && "Out of memory for workers");
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        args[t] = &job;
+    }
+    run_on_threads(minimal_worker_run, args, sizeof(*args), threads);
+    free(args);
+    return !job.removable;
+}
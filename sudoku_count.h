@@ -0,0 +1,40 @@
+#ifndef SUDOKU_COUNT_H
+#define SUDOKU_COUNT_H
+
+/*
+ * Counting and listing the solutions of a board, spread over threads
+ * The top of the search tree is expanded on the calling thread until there are enough subtrees for every thread,
+ * then the threads take subtrees until none are left. Each thread counts its own solutions and the counts are
+ * added up once the threads are done; the only thing they share while searching is an atomic total of the
+ * solutions found so far, so all of them stop as soon as the limit is reached
+ */
+
+/*
+ * Called with every solution found, in no particular order. With more than one thread it is called from
+ * several threads at the same time, so it must be thread safe
+ * Return 0 to stop listing solutions, >0 to go on
+ */
+typedef int (*SudokuSolutionCallback)(unsigned short int solution[9][9], void *context);
+
+/*
+ * Number of solutions of `board`, where counting stops at `limit`, searched on `threads` threads (0 for one per core)
+ * A limit of 2 is enough to tell a proper puzzle (exactly one solution) from one with several
+ */
+unsigned long long sudoku_count_solutions(unsigned short int board[9][9], unsigned long long limit, unsigned int threads);
+
+/*
+ * Calls `callback` with up to `limit` solutions of `board`, searched on `threads` threads (0 for one per core)
+ * Return the number of solutions passed to `callback`
+ */
+unsigned long long sudoku_enumerate_solutions(unsigned short int board[9][9], unsigned long long limit, unsigned int threads,
+                                              SudokuSolutionCallback callback, void *context);
+
+/*
+ * Tells whether `board` is a minimal puzzle: it has exactly one solution, and removing any one of its clues
+ * would give it more. The clues are checked on `threads` threads (0 for one per core), and checking stops at the
+ * first clue that could go. Each clue only needs one search for a solution without its value at that cell
+ * Return 0 if the board is not a minimal puzzle, >0 otherwise
+ */
+int sudoku_is_minimal(unsigned short int board[9][9], unsigned int threads);
+
+#endif // SUDOKU_COUNT_H
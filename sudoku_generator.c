@@ -0,0 +1,311 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "sudoku_generator.h"
+#include "sudoku_solver.h"
+#include "sudoku_solver_internal.h"
+#include "sudoku_trace.h"
+
+typedef struct GeneratorJob {
+    const SudokuGeneratorOptions *options;
+    size_t first;
+    SudokuBoard *puzzles;
+    SudokuBoard *solutions;
+    size_t count;
+    // Next puzzle nobody has started on yet, and how many were generated in total
+    pthread_mutex_t lock;
+    size_t next;
+    size_t generated;
+} GeneratorJob;
+
+/*
+ * splitmix64, small and fast, and any seed (even 0) gives a good sequence
+ */
+static unsigned long long next_random(unsigned long long *state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static unsigned int random_below(unsigned long long *state, unsigned int bound) {
+    return (unsigned int)(((next_random(state) >> 32) * bound) >> 32);
+}
+
+/*
+ * Fills every cell left in `solver` with a random valid grid, trying the candidates of each cell in random order
+ * Return 0 if the current state cannot be completed, >0 otherwise with the grid left in `solver`
+ */
+static int fill_randomly(SudokuSolver *solver, unsigned long long *random) {
+    if (!propagate_singles(solver))
+    {
+        return 0;
+    }
+
+    const unsigned short int cell = pick_search_cell(solver);
+    if (cell == 81)
+    {
+        return 1;
+    }
+
+    const unsigned short int i = cell / 9, j = cell % 9;
+    Notes options = solver->candidates[i][j];
+    while (options != 0)
+    {
+        // Picks the k-th candidate left, at random
+        Notes pick = options;
+        for (unsigned int k = random_below(random, __builtin_popcount(options)); k > 0; k--)
+        {
+            pick &= pick - 1;
+        }
+        const unsigned short int n = __builtin_ctz(pick) + 1;
+        options &= (Notes)~NOTES_BIT(n);
+
+        SudokuSolver guess = *solver;
+        handle_number_in_cell(&guess, n, i, j);
+        if (fill_randomly(&guess, random))
+        {
+            *solver = guess;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Tells whether `puzzle`, whose clues at `cell` and `partner` were just removed, has a solution other than the
+ * one it had before: `value` at `cell` and `partner_value` at `partner` (the same cell when removing a single clue).
+ * The puzzle had a unique solution with those clues, so any other solution must differ in one of the two cells.
+ * Looking for a solution where they differ stops at the first one found, which is much cheaper than counting two
+ * Return 0 if the solution is still unique, >0 otherwise
+ */
+static int has_other_solution(unsigned short int puzzle[9][9], unsigned short int cell, unsigned short int value,
+                              unsigned short int partner, unsigned short int partner_value)
+{
+    SudokuSolver solver;
+    sudoku_solver_init(&solver);
+    const int consistent = place_givens(&solver, puzzle);
+    assert(consistent && "Clues taken from a valid grid must be consistent");
+    (void)consistent;
+
+    SudokuSolver other = solver;
+    remove_candidate_from_cell(&other, value, cell / 9, cell % 9);
+    if (count_solutions(&other, 1) > 0)
+    {
+        return 1;
+    }
+    if (partner == cell)
+    {
+        return 0;
+    }
+
+    handle_number_in_cell(&solver, value, cell / 9, cell % 9);
+    remove_candidate_from_cell(&solver, partner_value, partner / 9, partner % 9);
+    return count_solutions(&solver, 1) > 0;
+}
+
+/*
+ * Clues left on the board, as the values present in each row, column and block
+ */
+typedef struct ClueMasks {
+    Notes row[9];
+    Notes column[9];
+    Notes block[9];
+} ClueMasks;
+
+static Notes clues_seen_from(const ClueMasks *clues, unsigned short int cell) {
+    const unsigned short int i = cell / 9, j = cell % 9;
+    return clues->row[i] | clues->column[j] | clues->block[(i / 3) * 3 + j / 3];
+}
+
+static void toggle_clue(ClueMasks *clues, unsigned short int cell, unsigned short int value) {
+    const unsigned short int i = cell / 9, j = cell % 9;
+    clues->row[i] ^= NOTES_BIT(value);
+    clues->column[j] ^= NOTES_BIT(value);
+    clues->block[(i / 3) * 3 + j / 3] ^= NOTES_BIT(value);
+}
+
+/*
+ * Tells whether the clues alone force `value` into the empty `cell`, as a naked single (its row, column and block
+ * hold every other value) or a hidden single (every other empty cell of one of its units sees `value` in a clue)
+ * While the board is still full of clues this settles most removals without solving anything
+ */
+static int forced_by_clues(unsigned short int puzzle[9][9], const ClueMasks *clues, unsigned short int cell,
+                           unsigned short int value)
+{
+    if ((clues_seen_from(clues, cell) | NOTES_BIT(value)) == NOTES_ALL_VALUES)
+    {
+        return 1;
+    }
+
+    const unsigned short int *board = &puzzle[0][0];
+    for (unsigned int units = sudoku_cell_units[cell]; units != 0; units &= units - 1)
+    {
+        const unsigned char *cells = sudoku_unit_cells[__builtin_ctz(units)];
+        unsigned short int k = 0;
+        while (k < 9 && (cells[k] == cell || board[cells[k]] != 0 || (clues_seen_from(clues, cells[k]) & NOTES_BIT(value)) != 0))
+        {
+            k++;
+        }
+        if (k == 9)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Removes clues from the full grid in `puzzle`, in random order, as long as the solution stays unique
+ */
+static void remove_clues(unsigned short int puzzle[9][9], int symmetric, unsigned long long *random) {
+    // With symmetry only the first half of the board (and the centre) is visited, the other half follows
+    const unsigned short int cells = symmetric ? 41 : 81;
+    unsigned char order[81];
+    for (unsigned short int k = 0; k < cells; k++)
+    {
+        const unsigned short int pick = random_below(random, k + 1);
+        order[k] = order[pick];
+        order[pick] = k;
+    }
+
+    ClueMasks clues;
+    for (unsigned short int k = 0; k < 9; k++)
+    {
+        clues.row[k] = clues.column[k] = clues.block[k] = NOTES_ALL_VALUES;
+    }
+
+    unsigned short int *board = &puzzle[0][0];
+    for (unsigned short int k = 0; k < cells; k++)
+    {
+        const unsigned short int cell = order[k];
+        const unsigned short int partner = symmetric ? 80 - cell : cell;
+        const unsigned short int value = board[cell], partner_value = board[partner];
+
+        board[cell] = 0;
+        board[partner] = 0;
+        toggle_clue(&clues, cell, value);
+        if (partner != cell)
+        {
+            toggle_clue(&clues, partner, partner_value);
+        }
+
+        // Cells the clues still force can only take their old value, otherwise it takes a search to be sure
+        const int forced = forced_by_clues(puzzle, &clues, cell, value)
+                           && (partner == cell || forced_by_clues(puzzle, &clues, partner, partner_value));
+        if (!forced && has_other_solution(puzzle, cell, value, partner, partner_value))
+        {
+            board[cell] = value;
+            board[partner] = partner_value;
+            toggle_clue(&clues, cell, value);
+            if (partner != cell)
+            {
+                toggle_clue(&clues, partner, partner_value);
+            }
+        }
+    }
+}
+
+static void *generator_worker_run(void *arg) {
+    GeneratorJob *job = arg;
+    size_t generated = 0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&job->lock);
+        const size_t index = job->next < job->count ? job->next++ : job->count;
+        pthread_mutex_unlock(&job->lock);
+        if (index == job->count)
+        {
+            break;
+        }
+
+        unsigned short int solution[9][9];
+        generated += sudoku_generate(job->options, job->first + index, job->puzzles[index],
+                                     job->solutions != NULL ? job->solutions[index] : solution);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    job->generated += generated;
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+// -- PUBLIC -- //
+void sudoku_generator_default_options(SudokuGeneratorOptions *options) {
+    options->seed = 0;
+    options->min_difficulty = 0.0;
+    options->max_difficulty = SUDOKU_DIFFICULTY_MAX;
+    options->symmetric = 0;
+}
+
+size_t sudoku_generate(const SudokuGeneratorOptions *options, size_t index,
+                       unsigned short int puzzle[9][9], unsigned short int solution[9][9])
+{
+    // Every puzzle has its own random sequence, so it does not depend on which thread generates it
+    unsigned long long random = options->seed;
+    random = next_random(&random) ^ index;
+    const int any_difficulty = options->min_difficulty <= 0.0 && options->max_difficulty >= SUDOKU_DIFFICULTY_MAX;
+
+    SudokuSolver solver;
+    SudokuTrace trace;
+    for (size_t attempts = 1;; attempts++)
+    {
+        sudoku_solver_init(&solver);
+        const int filled = fill_randomly(&solver, &random);
+        assert(filled && "An empty board always has a solution");
+        (void)filled;
+
+        for (unsigned short int cell = 0; cell < 81; cell++)
+        {
+            solution[cell / 9][cell % 9] = __builtin_ctz(solver.candidates[cell / 9][cell % 9]) + 1;
+        }
+        memcpy(puzzle, solution, sizeof(unsigned short int[9][9]));
+        remove_clues(puzzle, options->symmetric, &random);
+
+        if (any_difficulty)
+        {
+            return attempts;
+        }
+        unsigned short int solved[9][9];
+        const double difficulty = sudoku_solver_grade(&solver, &trace, puzzle, solved);
+        if (difficulty >= options->min_difficulty && difficulty < options->max_difficulty)
+        {
+            return attempts;
+        }
+    }
+}
+
+size_t sudoku_generate_batch(const SudokuGeneratorOptions *options, size_t first, SudokuBoard *puzzles,
+                             SudokuBoard *solutions, size_t count, unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = sudoku_batch_default_threads();
+    }
+
+    GeneratorJob job = { options, first, puzzles, solutions, count, PTHREAD_MUTEX_INITIALIZER, 0, 0 };
+    pthread_t *thread_ids = malloc(threads * sizeof(*thread_ids));
+    unsigned char *started = calloc(threads, 1);
+    assert(thread_ids != NULL && started != NULL && "Out of memory for generator bookkeeping");
+
+    // The calling thread generates too, so the batch completes even if no thread can be started
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        started[t] = pthread_create(&thread_ids[t], NULL, generator_worker_run, &job) == 0;
+    }
+    generator_worker_run(&job);
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(thread_ids[t], NULL);
+        }
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    free(started);
+    free(thread_ids);
+    return job.generated;
+}
@@ -0,0 +1,40 @@
+#ifndef SUDOKU_GENERATOR_H
+#define SUDOKU_GENERATOR_H
+
+#include <stddef.h>
+#include "sudoku_batch.h"
+
+typedef struct SudokuGeneratorOptions {
+    // Same seed, same puzzles, whatever the number of threads
+    unsigned long long seed;
+    // Only puzzles whose difficulty (see `sudoku_trace_difficulty`) falls in [min_difficulty, max_difficulty) are kept
+    double min_difficulty;
+    double max_difficulty;
+    // Clues are removed in pairs of cells opposite each other through the centre, like in printed puzzles
+    int symmetric;
+} SudokuGeneratorOptions;
+
+/*
+ * Options that accept any difficulty, with asymmetric clues and seed 0
+ */
+void sudoku_generator_default_options(SudokuGeneratorOptions *options);
+
+/*
+ * Generates the puzzle number `index` of the sequence of `options` into `puzzle`, and its solution into `solution`
+ * A random full grid is filled, then clues are removed in random order for as long as the solution stays unique,
+ * so every puzzle has exactly one solution and no clue can be removed without losing that.
+ * Puzzles outside of the difficulty range are thrown away and generated again, so narrow or rare ranges are slower.
+ * Return the number of puzzles that were generated until one was kept
+ */
+size_t sudoku_generate(const SudokuGeneratorOptions *options, size_t index,
+                       unsigned short int puzzle[9][9], unsigned short int solution[9][9]);
+
+/*
+ * Generates puzzles `first` to `first + count - 1` of the sequence of `options` into `puzzles` (and `solutions`,
+ * if not NULL), spread over `threads` threads (0 for one per core)
+ * Return the number of puzzles that were generated in total, including the ones thrown away for their difficulty
+ */
+size_t sudoku_generate_batch(const SudokuGeneratorOptions *options, size_t first, SudokuBoard *puzzles,
+                             SudokuBoard *solutions, size_t count, unsigned int threads);
+
+#endif // SUDOKU_GENERATOR_H
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "sudoku_grid.h"
+#include "sudoku_solver.h"
+#include "sudoku_parallel.h"
+#include "sudoku_batch.h"
+
+// Where the thread that finds the solution of a parallel search writes it
+typedef struct GridParallelSolve {
+    SudokuGrid *output;
+    int solved;
+} GridParallelSolve;
+
+#define GRID_BOX 2
+#include "sudoku_grid_template.h"
+#undef GRID_BOX
+
+#define GRID_BOX 4
+#include "sudoku_grid_template.h"
+#undef GRID_BOX
+
+#define GRID_BOX 5
+#include "sudoku_grid_template.h"
+#undef GRID_BOX
+
+/*
+ * 9x9 boards go to the hand written solver, `threads` 0 for `sudoku_solver_solve` and any other count for
+ * `sudoku_parallel_solve`
+ */
+static int solve_9x9(const SudokuGrid *input, SudokuGrid *output, unsigned int threads) {
+    SudokuSolver solver;
+    unsigned short int board[9][9], solution[9][9];
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        board[cell / 9][cell % 9] = input->cells[cell];
+    }
+
+    const int solvable = threads == 0 ? sudoku_solver_solve(&solver, board, solution)
+                                      : sudoku_parallel_solve(board, solution, threads);
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        output->cells[cell] = (unsigned char)solution[cell / 9][cell % 9];
+    }
+    return solvable;
+}
+
+// -- PUBLIC -- //
+int sudoku_grid_init(SudokuGrid *grid, unsigned short int box) {
+    if (box < SUDOKU_GRID_MIN_BOX || box > SUDOKU_GRID_MAX_BOX)
+    {
+        return 0;
+    }
+    grid->box = box;
+    grid->side = box * box;
+    memset(grid->cells, 0, sizeof(grid->cells));
+    return 1;
+}
+
+int sudoku_grid_solve(const SudokuGrid *input, SudokuGrid *output) {
+    output->box = input->box;
+    output->side = input->side;
+    switch (input->box)
+    {
+        case 2:
+            return grid_solve_2(input, output);
+        case 3:
+            return solve_9x9(input, output, 0);
+        case 4:
+            return grid_solve_4(input, output);
+        case 5:
+            return grid_solve_5(input, output);
+    }
+    assert(0 && "Unsupported box size");
+    return 0;
+}
+
+int sudoku_grid_solve_parallel(const SudokuGrid *input, SudokuGrid *output, unsigned int threads) {
+    if (threads == 0)
+    {
+        threads = sudoku_batch_default_threads();
+    }
+    output->box = input->box;
+    output->side = input->side;
+    switch (input->box)
+    {
+        case 2:
+            return grid_solve_parallel_2(input, output, threads);
+        case 3:
+            return solve_9x9(input, output, threads);
+        case 4:
+            return grid_solve_parallel_4(input, output, threads);
+        case 5:
+            return grid_solve_parallel_5(input, output, threads);
+    }
+    assert(0 && "Unsupported box size");
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef SUDOKU_GRID_H
+#define SUDOKU_GRID_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Boards of any supported size: boxes of 2x2 to 5x5 cells, so 4x4 up to 25x25 boards
+ * Every size has its own solver, generated at compile time from `sudoku_grid_template.h` with the size as a constant.
+ * 9x9 boards go to `sudoku_solver_solve`, which is written for that size by hand
+ */
+#define SUDOKU_GRID_MIN_BOX 2
+#define SUDOKU_GRID_MAX_BOX 5
+#define SUDOKU_GRID_MAX_SIDE (SUDOKU_GRID_MAX_BOX * SUDOKU_GRID_MAX_BOX)
+#define SUDOKU_GRID_MAX_CELLS (SUDOKU_GRID_MAX_SIDE * SUDOKU_GRID_MAX_SIDE)
+
+typedef struct SudokuGrid {
+    // Width of a box, the board is box*box cells wide
+    unsigned short int box;
+    unsigned short int side;
+    // Value of every cell (1 to side, 0 when empty), row after row: cell i*side+j
+    unsigned char cells[SUDOKU_GRID_MAX_CELLS];
+} SudokuGrid;
+
+/*
+ * Empties `grid` and gives it boxes `box` cells wide
+ * Return 0 if that size is not supported, >0 otherwise
+ */
+int sudoku_grid_init(SudokuGrid *grid, unsigned short int box);
+
+/*
+ * Solves `input` into `output` (which gets the size of `input`), with naked and hidden singles and guessing,
+ * like `sudoku_solver_solve` does for 9x9 boards
+ * Return 0 if the board has no solution, >0 otherwise. Cells that could not be solved are left at 0 in `output`
+ */
+int sudoku_grid_solve(const SudokuGrid *input, SudokuGrid *output);
+
+/*
+ * Solves `input` into `output` like `sudoku_grid_solve`, with the guessing spread over `threads` threads (0 for one
+ * per core) through `sudoku_search_pool_run`, for the single hard boards whose own latency matters
+ * Return 0 if the board has no solution, >0 otherwise. Cells that could not be solved are left at 0 in `output`, the
+ * same cells as with `sudoku_grid_solve`
+ */
+int sudoku_grid_solve_parallel(const SudokuGrid *input, SudokuGrid *output, unsigned int threads);
+
+#endif // SUDOKU_GRID_H
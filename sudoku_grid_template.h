@@ -0,0 +1,492 @@
+/*
+ * Solver for boards of one size, included once per size by `sudoku_grid.c` with GRID_BOX set to the width of a box
+ * Every bound is a constant, so the compiler unrolls and folds the loops for that size, and the candidates of a cell
+ * fit the smallest native word that holds them. Everything defined here gets the box width as suffix (`grid_solve_4`)
+ * No include guard on purpose
+ */
+
+#ifndef GRID_BOX
+#error "GRID_BOX must be defined before including sudoku_grid_template.h"
+#endif
+
+#define GRID_SIDE (GRID_BOX * GRID_BOX)
+#define GRID_CELLS (GRID_SIDE * GRID_SIDE)
+#define GRID_UNITS (3 * GRID_SIDE)
+#define GRID_ALL_VALUES ((GRID_NAME(GridNotes))((1ull << GRID_SIDE) - 1))
+
+#define GRID_PASTE_(name, box) name##_##box
+#define GRID_PASTE(name, box) GRID_PASTE_(name, box)
+#define GRID_NAME(name) GRID_PASTE(name, GRID_BOX)
+
+// Bit n-1 is set if n is still a candidate of the cell, like `Notes`
+#if GRID_SIDE <= 16
+typedef unsigned short int GRID_NAME(GridNotes);
+#else
+typedef unsigned int GRID_NAME(GridNotes);
+#endif
+
+/*
+ * Candidates of cells as they were before each change, latest last, so that a guess is taken back by undoing only
+ * what it changed instead of copying the whole state for every guess. Every change removes at least one candidate
+ * of a cell, which bounds the number of entries
+ */
+typedef struct GRID_NAME(GridTrail) {
+    size_t length;
+    struct {
+        unsigned short int cell;
+        GRID_NAME(GridNotes) before;
+    } entries[GRID_CELLS * (GRID_SIDE - 1)];
+} GRID_NAME(GridTrail);
+
+typedef struct GRID_NAME(GridState) {
+    GRID_NAME(GridNotes) candidates[GRID_CELLS];
+    // 1 once the cell has its value and it was removed from its peers
+    unsigned char placed[GRID_CELLS];
+    // Cells in the order they were placed, the first `placed_count` of them
+    unsigned short int placed_cells[GRID_CELLS];
+    unsigned short int placed_count;
+    // Cells down to one candidate (or none) that are not placed yet. A cell is queued at most twice, at one and at none
+    unsigned short int pending_count;
+    unsigned short int pending[2 * GRID_CELLS];
+    GRID_NAME(GridTrail) *trail;
+} GRID_NAME(GridState);
+
+// What a rollback goes back to: the state is rebuilt from the trail and the order in which cells were placed
+typedef struct GRID_NAME(GridCheckpoint) {
+    size_t length;
+    unsigned short int placed_count;
+} GRID_NAME(GridCheckpoint);
+
+// Board index of the k-th cell of `unit`: rows are units 0 to side-1, then the columns, then the boxes
+static inline unsigned short int GRID_NAME(grid_unit_cell)(unsigned short int unit, unsigned short int k) {
+    if (unit < GRID_SIDE)
+    {
+        return unit * GRID_SIDE + k;
+    }
+    if (unit < 2 * GRID_SIDE)
+    {
+        return k * GRID_SIDE + (unit - GRID_SIDE);
+    }
+    const unsigned short int box = unit - 2 * GRID_SIDE;
+    return ((box / GRID_BOX) * GRID_BOX + k / GRID_BOX) * GRID_SIDE + (box % GRID_BOX) * GRID_BOX + k % GRID_BOX;
+}
+
+static void GRID_NAME(grid_init_state)(GRID_NAME(GridState) *state, GRID_NAME(GridTrail) *trail) {
+    for (unsigned short int cell = 0; cell < GRID_CELLS; cell++)
+    {
+        state->candidates[cell] = GRID_ALL_VALUES;
+        state->placed[cell] = 0;
+    }
+    state->placed_count = 0;
+    state->pending_count = 0;
+    state->trail = trail;
+    trail->length = 0;
+}
+
+// Changes the candidates of `cell` to `notes`, which must be fewer than it has now
+static inline void GRID_NAME(grid_write)(GRID_NAME(GridState) *state, unsigned short int cell,
+                                         GRID_NAME(GridNotes) notes) {
+    GRID_NAME(GridTrail) *trail = state->trail;
+    assert(trail->length < sizeof(trail->entries) / sizeof(*trail->entries) && "Trail longer than its bound");
+    trail->entries[trail->length].cell = cell;
+    trail->entries[trail->length].before = state->candidates[cell];
+    trail->length++;
+    state->candidates[cell] = notes;
+}
+
+/*
+ * Only taken between two propagations, when no cell is queued
+ */
+static inline GRID_NAME(GridCheckpoint) GRID_NAME(grid_checkpoint)(const GRID_NAME(GridState) *state) {
+    assert(state->pending_count == 0 && "Checkpoint with queued cells");
+    return (GRID_NAME(GridCheckpoint)){ state->trail->length, state->placed_count };
+}
+
+// Undoes every change made since `checkpoint`, newest first
+static void GRID_NAME(grid_rollback)(GRID_NAME(GridState) *state, GRID_NAME(GridCheckpoint) checkpoint) {
+    GRID_NAME(GridTrail) *trail = state->trail;
+    while (trail->length > checkpoint.length)
+    {
+        trail->length--;
+        state->candidates[trail->entries[trail->length].cell] = trail->entries[trail->length].before;
+    }
+    while (state->placed_count > checkpoint.placed_count)
+    {
+        state->placed[state->placed_cells[--state->placed_count]] = 0;
+    }
+    state->pending_count = 0;
+}
+
+/*
+ * Removes `value` (as a bit) from `cell`, and queues the cell if that leaves it a single candidate
+ * Return 0 if the cell has no candidate left, >0 otherwise
+ */
+static inline int GRID_NAME(grid_remove_candidate)(GRID_NAME(GridState) *state, unsigned short int cell,
+                                                   GRID_NAME(GridNotes) value) {
+    GRID_NAME(GridNotes) *notes = &state->candidates[cell];
+    if ((*notes & value) == 0)
+    {
+        return 1;
+    }
+
+    GRID_NAME(grid_write)(state, cell, *notes & (GRID_NAME(GridNotes))~value);
+    if ((*notes & (*notes - 1)) == 0)
+    {
+        state->pending[state->pending_count++] = cell;
+    }
+    return *notes != 0;
+}
+
+/*
+ * Places `value` (as a bit) in the unplaced `cell` and removes it from every other cell of its row, column and box
+ * Return 0 if `value` is not a candidate of the cell or a peer is left without candidates, >0 otherwise
+ */
+static int GRID_NAME(grid_place)(GRID_NAME(GridState) *state, unsigned short int cell, GRID_NAME(GridNotes) value) {
+    if ((state->candidates[cell] & value) == 0)
+    {
+        return 0;
+    }
+    if (state->candidates[cell] != value)
+    {
+        GRID_NAME(grid_write)(state, cell, value);
+    }
+    state->placed[cell] = 1;
+    state->placed_cells[state->placed_count++] = cell;
+
+    const unsigned short int i = cell / GRID_SIDE, j = cell % GRID_SIDE;
+    const unsigned short int box = (i / GRID_BOX) * GRID_BOX + j / GRID_BOX;
+    int ok = 1;
+    for (unsigned short int k = 0; k < GRID_SIDE; k++)
+    {
+        const unsigned short int row_peer = i * GRID_SIDE + k;
+        const unsigned short int column_peer = k * GRID_SIDE + j;
+        const unsigned short int box_peer = GRID_NAME(grid_unit_cell)(2 * GRID_SIDE + box, k);
+        if (row_peer != cell)
+        {
+            ok &= GRID_NAME(grid_remove_candidate)(state, row_peer, value);
+        }
+        if (column_peer != cell)
+        {
+            ok &= GRID_NAME(grid_remove_candidate)(state, column_peer, value);
+        }
+        // The peers of the box in the same row or column were just done
+        if (box_peer / GRID_SIDE != i && box_peer % GRID_SIDE != j)
+        {
+            ok &= GRID_NAME(grid_remove_candidate)(state, box_peer, value);
+        }
+    }
+    return ok;
+}
+
+/*
+ * Places the values that fit in a single cell of a unit
+ * Return 0 on a contradiction, >0 otherwise, with `*progress` set if anything was placed
+ */
+static int GRID_NAME(grid_hidden_singles)(GRID_NAME(GridState) *state, int *progress) {
+    for (unsigned short int unit = 0; unit < GRID_UNITS; unit++)
+    {
+        GRID_NAME(GridNotes) seen_once = 0, seen_twice = 0;
+        for (unsigned short int k = 0; k < GRID_SIDE; k++)
+        {
+            const GRID_NAME(GridNotes) notes = state->candidates[GRID_NAME(grid_unit_cell)(unit, k)];
+            seen_twice |= seen_once & notes;
+            seen_once |= notes;
+        }
+        if (seen_once != GRID_ALL_VALUES)
+        {
+            return 0;
+        }
+
+        const GRID_NAME(GridNotes) hidden = seen_once & (GRID_NAME(GridNotes))~seen_twice;
+        if (hidden == 0)
+        {
+            continue;
+        }
+        for (unsigned short int k = 0; k < GRID_SIDE; k++)
+        {
+            const unsigned short int cell = GRID_NAME(grid_unit_cell)(unit, k);
+            const GRID_NAME(GridNotes) hit = state->candidates[cell] & hidden;
+            if (hit == 0 || state->placed[cell])
+            {
+                continue;
+            }
+            // Two values that both have nowhere else to go
+            if ((hit & (hit - 1)) != 0 || !GRID_NAME(grid_place)(state, cell, hit))
+            {
+                return 0;
+            }
+            *progress = 1;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Removes `values` from the cells of `unit` outside of the line or box they share with `other`
+ * Return 0 if a cell is left without candidates, >0 otherwise, with `*progress` set if anything was removed
+ */
+static int GRID_NAME(grid_remove_outside)(GRID_NAME(GridState) *state, unsigned short int unit, unsigned short int other,
+                                          GRID_NAME(GridNotes) values, int *progress) {
+    int ok = 1;
+    for (unsigned short int k = 0; k < GRID_SIDE; k++)
+    {
+        const unsigned short int cell = GRID_NAME(grid_unit_cell)(unit, k);
+        const unsigned short int i = cell / GRID_SIDE, j = cell % GRID_SIDE;
+        const unsigned short int box = 2 * GRID_SIDE + (i / GRID_BOX) * GRID_BOX + j / GRID_BOX;
+        const int shared = other == box || other == i || other == GRID_SIDE + j;
+        if (!shared && (state->candidates[cell] & values) != 0)
+        {
+            *progress = 1;
+            ok &= GRID_NAME(grid_remove_candidate)(state, cell, state->candidates[cell] & values);
+        }
+    }
+    return ok;
+}
+
+/*
+ * Locked candidates: a value of a box whose cells there are all on one row (or column) can't be anywhere else
+ * on that row, and a value of a row whose cells are all inside one box can't be anywhere else in that box.
+ * Big boards get stuck on these more than on anything else
+ * Return 0 on a contradiction, >0 otherwise, with `*progress` set if anything was removed
+ */
+static int GRID_NAME(grid_locked_candidates)(GRID_NAME(GridState) *state, int *progress) {
+    for (unsigned short int box = 0; box < GRID_SIDE; box++)
+    {
+        const unsigned short int top = (box / GRID_BOX) * GRID_BOX, left = (box % GRID_BOX) * GRID_BOX;
+        for (unsigned short int line = 0; line < 2 * GRID_BOX; line++)
+        {
+            // The first BOX lines are the rows through the box, the others its columns
+            const int is_row = line < GRID_BOX;
+            const unsigned short int unit = is_row ? top + line : GRID_SIDE + left + line - GRID_BOX;
+            GRID_NAME(GridNotes) inside = 0, rest_of_line = 0, rest_of_box = 0;
+            for (unsigned short int k = 0; k < GRID_SIDE; k++)
+            {
+                const unsigned short int line_cell = GRID_NAME(grid_unit_cell)(unit, k);
+                const unsigned short int box_cell = GRID_NAME(grid_unit_cell)(2 * GRID_SIDE + box, k);
+                const unsigned short int along = is_row ? line_cell % GRID_SIDE : line_cell / GRID_SIDE;
+                const unsigned short int start = is_row ? left : top;
+                const unsigned short int box_line = is_row ? box_cell / GRID_SIDE : GRID_SIDE + box_cell % GRID_SIDE;
+                if (along >= start && along < start + GRID_BOX)
+                {
+                    inside |= state->candidates[line_cell];
+                }
+                else
+                {
+                    rest_of_line |= state->candidates[line_cell];
+                }
+                if (box_line != unit)
+                {
+                    rest_of_box |= state->candidates[box_cell];
+                }
+            }
+
+            const GRID_NAME(GridNotes) pointing = inside & (GRID_NAME(GridNotes))~rest_of_box & rest_of_line;
+            const GRID_NAME(GridNotes) claiming = inside & (GRID_NAME(GridNotes))~rest_of_line & rest_of_box;
+            if ((pointing != 0 && !GRID_NAME(grid_remove_outside)(state, unit, 2 * GRID_SIDE + box, pointing, progress))
+                || (claiming != 0 && !GRID_NAME(grid_remove_outside)(state, 2 * GRID_SIDE + box, unit, claiming, progress)))
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * Applies naked and hidden singles until neither makes progress, then locked candidates, and so on until
+ * none of them do
+ * Return 0 on a contradiction, >0 otherwise
+ */
+static int GRID_NAME(grid_propagate)(GRID_NAME(GridState) *state) {
+    int progress;
+    do
+    {
+        while (state->pending_count > 0)
+        {
+            const unsigned short int cell = state->pending[--state->pending_count];
+            if (!state->placed[cell] && !GRID_NAME(grid_place)(state, cell, state->candidates[cell]))
+            {
+                return 0;
+            }
+        }
+
+        progress = 0;
+        if (state->placed_count < GRID_CELLS && !GRID_NAME(grid_hidden_singles)(state, &progress))
+        {
+            return 0;
+        }
+        if (!progress && state->pending_count == 0 && state->placed_count < GRID_CELLS
+            && !GRID_NAME(grid_locked_candidates)(state, &progress))
+        {
+            return 0;
+        }
+    } while (progress || state->pending_count > 0);
+    return 1;
+}
+
+// Unplaced cell with the fewest candidates, GRID_CELLS once every cell is placed
+static unsigned short int GRID_NAME(grid_pick_cell)(const GRID_NAME(GridState) *state) {
+    unsigned short int best = GRID_CELLS;
+    int best_count = GRID_SIDE + 1;
+    for (unsigned short int cell = 0; cell < GRID_CELLS && best_count > 2; cell++)
+    {
+        const int count = __builtin_popcount(state->candidates[cell]);
+        if (!state->placed[cell] && count < best_count)
+        {
+            best = cell;
+            best_count = count;
+        }
+    }
+    return best;
+}
+
+static void GRID_NAME(grid_write_output)(const GRID_NAME(GridState) *state, SudokuGrid *output) {
+    for (unsigned short int cell = 0; cell < GRID_CELLS; cell++)
+    {
+        output->cells[cell] = state->placed[cell] ? __builtin_ctz(state->candidates[cell]) + 1 : 0;
+    }
+}
+
+/*
+ * Guesses the value of the cell with the fewest candidates, and rolls back what a wrong guess changed
+ * Return 0 if the board has no solution, >0 otherwise with the solution in `state`
+ */
+static int GRID_NAME(grid_search)(GRID_NAME(GridState) *state) {
+    if (!GRID_NAME(grid_propagate)(state))
+    {
+        return 0;
+    }
+    if (state->placed_count == GRID_CELLS)
+    {
+        return 1;
+    }
+
+    const unsigned short int best = GRID_NAME(grid_pick_cell)(state);
+    for (GRID_NAME(GridNotes) options = state->candidates[best]; options != 0; options &= options - 1)
+    {
+        const GRID_NAME(GridCheckpoint) checkpoint = GRID_NAME(grid_checkpoint)(state);
+        if (GRID_NAME(grid_place)(state, best, options & -options) && GRID_NAME(grid_search)(state))
+        {
+            return 1;
+        }
+        GRID_NAME(grid_rollback)(state, checkpoint);
+    }
+    return 0;
+}
+
+/*
+ * `grid_search` with the branches not taken yet pushed to `pool` while another thread is idle. A pushed branch is
+ * copied with its guess placed and then rolled back here, so the trail of this thread never leaves it
+ * Return 0 if the board has no solution from this state or another thread found one first, >0 otherwise
+ */
+static int GRID_NAME(grid_parallel_search)(SudokuSearchPool *pool, unsigned int worker, GRID_NAME(GridState) *state,
+                                           GridParallelSolve *result)
+{
+    if (sudoku_search_pool_stopped(pool) || !GRID_NAME(grid_propagate)(state))
+    {
+        return 0;
+    }
+    if (state->placed_count == GRID_CELLS)
+    {
+        if (!sudoku_search_pool_stop(pool))
+        {
+            return 0;
+        }
+        GRID_NAME(grid_write_output)(state, result->output);
+        result->solved = 1;
+        return 1;
+    }
+
+    const unsigned short int best = GRID_NAME(grid_pick_cell)(state);
+    for (GRID_NAME(GridNotes) options = state->candidates[best]; options != 0; options &= options - 1)
+    {
+        const GRID_NAME(GridCheckpoint) checkpoint = GRID_NAME(grid_checkpoint)(state);
+        if (GRID_NAME(grid_place)(state, best, options & -options))
+        {
+            // The last branch is always kept, it is the one this thread goes on with
+            if ((options & (options - 1)) == 0 || !sudoku_search_pool_hungry(pool, worker)
+                || !sudoku_search_pool_push(pool, worker, state))
+            {
+                if (GRID_NAME(grid_parallel_search)(pool, worker, state, result))
+                {
+                    return 1;
+                }
+            }
+        }
+        GRID_NAME(grid_rollback)(state, checkpoint);
+    }
+    return 0;
+}
+
+static void GRID_NAME(grid_parallel_task)(SudokuSearchPool *pool, unsigned int worker, void *task, void *context) {
+    GRID_NAME(GridState) *state = task;
+    // The trail of the thread that pushed the task holds nothing this one has to undo
+    GRID_NAME(GridTrail) trail;
+    trail.length = 0;
+    state->trail = &trail;
+    GRID_NAME(grid_parallel_search)(pool, worker, state, context);
+}
+
+/*
+ * Places the givens of `input`
+ * Return 0 if two of them are in conflict, >0 otherwise
+ */
+static int GRID_NAME(grid_place_givens)(GRID_NAME(GridState) *state, const SudokuGrid *input) {
+    int solvable = 1;
+    for (unsigned short int cell = 0; cell < GRID_CELLS && solvable; cell++)
+    {
+        const unsigned short int n = input->cells[cell];
+        if (n >= 1 && n <= GRID_SIDE)
+        {
+            // A given that was already removed from this cell repeats another given in its row/column/box
+            solvable = GRID_NAME(grid_place)(state, cell, (GRID_NAME(GridNotes))(1u << (n - 1)));
+        }
+    }
+    return solvable;
+}
+
+static int GRID_NAME(grid_solve)(const SudokuGrid *input, SudokuGrid *output) {
+    GRID_NAME(GridState) state;
+    GRID_NAME(GridTrail) trail;
+    GRID_NAME(grid_init_state)(&state, &trail);
+
+    const int solvable = GRID_NAME(grid_place_givens)(&state, input) && GRID_NAME(grid_search)(&state);
+    GRID_NAME(grid_write_output)(&state, output);
+    return solvable;
+}
+
+static int GRID_NAME(grid_solve_parallel)(const SudokuGrid *input, SudokuGrid *output, unsigned int threads) {
+    GRID_NAME(GridState) *state = malloc(sizeof(*state));
+    GRID_NAME(GridTrail) *trail = malloc(sizeof(*trail));
+    assert(state != NULL && trail != NULL && "Out of memory for the board");
+    GRID_NAME(grid_init_state)(state, trail);
+
+    GridParallelSolve result = { output, 0 };
+    if (GRID_NAME(grid_place_givens)(state, input) && GRID_NAME(grid_propagate)(state))
+    {
+        if (state->placed_count < GRID_CELLS)
+        {
+            sudoku_search_pool_run(state, sizeof(*state), GRID_NAME(grid_parallel_task), &result, threads);
+        }
+        else
+        {
+            result.solved = 1;
+        }
+    }
+    // Without a solution the board is left as it was before guessing, which is where `grid_search` rolls back to
+    if (!result.solved || state->placed_count == GRID_CELLS)
+    {
+        GRID_NAME(grid_write_output)(state, output);
+    }
+    free(trail);
+    free(state);
+    return result.solved;
+}
+
+#undef GRID_SIDE
+#undef GRID_CELLS
+#undef GRID_UNITS
+#undef GRID_ALL_VALUES
+#undef GRID_PASTE_
+#undef GRID_PASTE
+#undef GRID_NAME
@@ -0,0 +1,270 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sudoku_io.h"
+#include "sudoku_util.h"
+
+#define SUDOKU_IO_BUFFER_SIZE (1 << 20)
+
+// Mapped pages behind the read position are given back to the kernel in steps of this size
+#define SUDOKU_IO_RELEASE_STEP (64 << 20)
+
+// A full line: 81 cells and the newline
+#define SUDOKU_LINE_LENGTH 82
+
+static int open_path(const char *path, int flags, int fallback_fd) {
+    if (path == NULL || strcmp(path, "-") == 0)
+    {
+        return fallback_fd;
+    }
+    return open(path, flags, 0644);
+}
+
+/*
+ * Moves what is left of the buffer to its start and reads more after it
+ * Return 0 if nothing more could be read, >0 otherwise
+ */
+static int reader_refill(SudokuReader *reader) {
+    if (reader->mapped || reader->at_eof)
+    {
+        return 0;
+    }
+
+    const size_t left = reader->size - reader->offset;
+    memmove(reader->buffer, reader->buffer + reader->offset, left);
+    reader->size = left;
+    reader->offset = 0;
+
+    // A line that fills the whole buffer can't be a puzzle, drop it
+    if (reader->size == reader->capacity)
+    {
+        reader->size = 0;
+    }
+
+    const size_t before = reader->size;
+    while (reader->size < reader->capacity)
+    {
+        const ssize_t bytes = read(reader->fd, reader->buffer + reader->size, reader->capacity - reader->size);
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes <= 0)
+        {
+            reader->at_eof = 1;
+            break;
+        }
+        reader->size += bytes;
+        // Hand back whatever a pipe gave us, instead of waiting for the whole buffer to fill
+        break;
+    }
+    reader->data = reader->buffer;
+    return reader->size > before;
+}
+
+static void reader_release_pages(SudokuReader *reader) {
+    if (!reader->mapped || reader->offset - reader->released < SUDOKU_IO_RELEASE_STEP)
+    {
+        return;
+    }
+
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t end = reader->offset / page * page;
+    madvise((char *)reader->data + reader->released, end - reader->released, MADV_DONTNEED);
+    reader->released = end;
+}
+
+/*
+ * Finds the next line of the input, without its newline
+ * Return 0 once there are no lines left, >0 otherwise
+ */
+static int reader_next_line(SudokuReader *reader, const char **line, size_t *length) {
+    for (;;)
+    {
+        const char *start = reader->data + reader->offset;
+        const size_t left = reader->size - reader->offset;
+        const char *newline = memchr(start, '\n', left);
+
+        if (newline != NULL)
+        {
+            *length = newline - start;
+            reader->offset += *length + 1;
+        }
+        else if (reader_refill(reader))
+        {
+            continue;
+        }
+        else if (left > 0)
+        {
+            // Last line of the input, without a newline
+            *length = left;
+            reader->offset += left;
+        }
+        else
+        {
+            return 0;
+        }
+        *line = start;
+        return 1;
+    }
+}
+
+// -- PUBLIC -- //
+int sudoku_reader_open(SudokuReader *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = open_path(path, O_RDONLY, STDIN_FILENO);
+    if (reader->fd < 0)
+    {
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(reader->fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+        if (data != MAP_FAILED)
+        {
+            madvise(data, info.st_size, MADV_SEQUENTIAL);
+            reader->mapped = 1;
+            reader->data = data;
+            reader->size = info.st_size;
+            return 1;
+        }
+    }
+
+    reader->capacity = SUDOKU_IO_BUFFER_SIZE;
+    reader->buffer = malloc(reader->capacity);
+    assert(reader->buffer != NULL && "Out of memory for the input buffer");
+    reader->data = reader->buffer;
+    return 1;
+}
+
+int sudoku_reader_next(SudokuReader *reader, unsigned short int board[9][9]) {
+    const char *line;
+    size_t length;
+    while (reader_next_line(reader, &line, &length))
+    {
+        if (length >= 81 && parse_sudoku_line(line, board))
+        {
+            reader_release_pages(reader);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int sudoku_reader_next_grid(SudokuReader *reader, SudokuGrid *grid) {
+    const char *line;
+    size_t length;
+    while (reader_next_line(reader, &line, &length))
+    {
+        // Windows line endings
+        if (length > 0 && line[length - 1] == '\r')
+        {
+            length--;
+        }
+        if (parse_grid_line(line, length, grid))
+        {
+            reader_release_pages(reader);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+size_t sudoku_reader_next_batch(SudokuReader *reader, unsigned short int (*boards)[9][9], size_t max) {
+    size_t count = 0;
+    while (count < max && sudoku_reader_next(reader, boards[count]))
+    {
+        count++;
+    }
+    return count;
+}
+
+void sudoku_reader_close(SudokuReader *reader) {
+    if (reader->mapped)
+    {
+        munmap((void *)reader->data, reader->size);
+    }
+    free(reader->buffer);
+    if (reader->fd > STDERR_FILENO)
+    {
+        close(reader->fd);
+    }
+    memset(reader, 0, sizeof(*reader));
+}
+
+int sudoku_writer_open(SudokuWriter *writer, const char *path) {
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = open_path(path, O_WRONLY | O_CREAT | O_TRUNC, STDOUT_FILENO);
+    if (writer->fd < 0)
+    {
+        return 0;
+    }
+
+    writer->capacity = SUDOKU_IO_BUFFER_SIZE;
+    writer->buffer = malloc(writer->capacity);
+    assert(writer->buffer != NULL && "Out of memory for the output buffer");
+    return 1;
+}
+
+void sudoku_writer_put(SudokuWriter *writer, unsigned short int board[9][9]) {
+    if (writer->capacity - writer->used < SUDOKU_LINE_LENGTH)
+    {
+        sudoku_writer_flush(writer);
+    }
+
+    format_sudoku_line(board, writer->buffer + writer->used);
+    writer->buffer[writer->used + 81] = '\n';
+    writer->used += SUDOKU_LINE_LENGTH;
+}
+
+void sudoku_writer_put_grid(SudokuWriter *writer, const SudokuGrid *grid) {
+    const size_t cells = (size_t)grid->side * grid->side;
+    if (writer->capacity - writer->used < cells + 1)
+    {
+        sudoku_writer_flush(writer);
+    }
+
+    format_grid_line(grid, writer->buffer + writer->used);
+    writer->buffer[writer->used + cells] = '\n';
+    writer->used += cells + 1;
+}
+
+int sudoku_writer_flush(SudokuWriter *writer) {
+    size_t written = 0;
+    while (written < writer->used && !writer->failed)
+    {
+        const ssize_t bytes = write(writer->fd, writer->buffer + written, writer->used - written);
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes <= 0)
+        {
+            writer->failed = 1;
+            break;
+        }
+        written += bytes;
+    }
+    writer->used = 0;
+    return !writer->failed;
+}
+
+int sudoku_writer_close(SudokuWriter *writer) {
+    const int ok = sudoku_writer_flush(writer);
+    free(writer->buffer);
+    if (writer->fd > STDERR_FILENO)
+    {
+        close(writer->fd);
+    }
+    memset(writer, 0, sizeof(*writer));
+    return ok;
+}
@@ -0,0 +1,84 @@
+#ifndef SUDOKU_IO_H
+#define SUDOKU_IO_H
+
+#include <stddef.h>
+#include "sudoku_grid.h"
+
+/*
+ * Streaming reader of puzzles in the one-line format (see `parse_sudoku_line`), one puzzle per line
+ * Regular files are memory mapped and parsed in place, so only the pages being read have to be in memory.
+ * Anything else (stdin, pipes) is read through a fixed size buffer. Lines that are not a puzzle are skipped
+ */
+typedef struct SudokuReader {
+    int fd;
+    int mapped;
+    const char *data;
+    size_t size;
+    size_t offset;
+    // Start of the mapped pages that have not been given back to the kernel yet
+    size_t released;
+    // Only used when the input is not mapped
+    char *buffer;
+    size_t capacity;
+    int at_eof;
+} SudokuReader;
+
+/*
+ * Opens `path` for reading, or stdin if `path` is NULL or "-"
+ * Return 0 if the file could not be opened, >0 otherwise
+ */
+int sudoku_reader_open(SudokuReader *reader, const char *path);
+
+/*
+ * Reads the next puzzle into `board`
+ * Return 0 once there are no puzzles left, >0 otherwise
+ */
+int sudoku_reader_next(SudokuReader *reader, unsigned short int board[9][9]);
+
+/*
+ * Reads the next puzzle of any supported size into `grid` (see `parse_grid_line`), skipping lines of other lengths
+ * Return 0 once there are no puzzles left, >0 otherwise
+ */
+int sudoku_reader_next_grid(SudokuReader *reader, SudokuGrid *grid);
+
+/*
+ * Reads up to `max` puzzles into `boards`
+ * Return the number of puzzles read, 0 once there are no puzzles left
+ */
+size_t sudoku_reader_next_batch(SudokuReader *reader, unsigned short int (*boards)[9][9], size_t max);
+
+void sudoku_reader_close(SudokuReader *reader);
+
+/*
+ * Buffered writer of boards in the one-line format, one board per line
+ */
+typedef struct SudokuWriter {
+    int fd;
+    int failed;
+    char *buffer;
+    size_t used;
+    size_t capacity;
+} SudokuWriter;
+
+/*
+ * Writes to `path`, or stdout if `path` is NULL or "-"
+ * Return 0 if the file could not be created, >0 otherwise
+ */
+int sudoku_writer_open(SudokuWriter *writer, const char *path);
+
+void sudoku_writer_put(SudokuWriter *writer, unsigned short int board[9][9]);
+
+void sudoku_writer_put_grid(SudokuWriter *writer, const SudokuGrid *grid);
+
+/*
+ * Return 0 if any write so far has failed, >0 otherwise
+ */
+int sudoku_writer_flush(SudokuWriter *writer);
+
+/*
+ * Flushes and closes the writer
+ * Return 0 if any write has failed, >0 otherwise
+ */
+int sudoku_writer_close(SudokuWriter *writer);
+
+#endif // SUDOKU_IO_H
@@ -0,0 +1,270 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+#include <time.h>
+#include "sudoku_lockstep.h"
+#include "sudoku_solver_internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LOCKSTEP_X86 1
+#else
+#define LOCKSTEP_X86 0
+#endif
+
+// One cell of every lane. Comparisons give -1 in the lanes where they hold and 0 elsewhere, used as masks
+typedef unsigned short int LaneNotes __attribute__((vector_size(SUDOKU_LOCKSTEP_LANES * sizeof(Notes))));
+
+// Lane that holds no board
+#define NO_BOARD ((size_t)-1)
+
+typedef struct LaneFlags {
+    // Lanes with a cell without candidates, a value twice in a unit or a value with no cell left in a unit
+    LaneNotes bad;
+    // Lanes with a cell that had more than one candidate at the start of the round
+    LaneNotes unsolved;
+    // Lanes where the round removed a candidate
+    LaneNotes changed;
+} LaneFlags;
+
+/*
+ * One round of naked and hidden singles on every lane: the values of cells with a single candidate are removed from
+ * their peers, then the values left with a single cell in a unit are placed there.
+ * Written once for the whole of the lanes, and compiled for each instruction set it is dispatched to
+ */
+static inline __attribute__((always_inline)) void lockstep_round_body(LaneNotes cells[81], LaneFlags *flags) {
+    const LaneNotes zero = {0};
+    const LaneNotes all_values = zero + NOTES_ALL_VALUES;
+    LaneNotes fixed[81];
+    LaneNotes placed[27];
+    LaneNotes bad = zero, unsolved = zero, changed = zero;
+
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const LaneNotes notes = cells[cell];
+        const LaneNotes single = (LaneNotes)((notes & (notes - 1)) == 0);
+        fixed[cell] = notes & single;
+        unsolved |= ~single;
+        bad |= (LaneNotes)(notes == 0);
+    }
+
+    for (unsigned short int unit = 0; unit < 27; unit++)
+    {
+        LaneNotes seen_once = zero, seen_twice = zero;
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            const LaneNotes notes = fixed[sudoku_unit_cells[unit][k]];
+            seen_twice |= seen_once & notes;
+            seen_once |= notes;
+        }
+        placed[unit] = seen_once;
+        bad |= seen_twice;
+    }
+
+    // A placed cell keeps its value, which is the only one of its peers it has
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const unsigned short int i = cell / 9, j = cell % 9;
+        const LaneNotes peers = placed[i] | placed[9 + j] | placed[18 + (i / 3) * 3 + j / 3];
+        const LaneNotes notes = fixed[cell] | (cells[cell] & ~peers);
+        changed |= notes ^ cells[cell];
+        cells[cell] = notes;
+    }
+
+    for (unsigned short int unit = 0; unit < 27; unit++)
+    {
+        const unsigned char *unit_cells = sudoku_unit_cells[unit];
+        LaneNotes seen_once = zero, seen_twice = zero;
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            const LaneNotes notes = cells[unit_cells[k]];
+            seen_twice |= seen_once & notes;
+            seen_once |= notes;
+        }
+        bad |= seen_once ^ all_values;
+
+        const LaneNotes hidden = seen_once & ~seen_twice;
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            const LaneNotes notes = cells[unit_cells[k]];
+            const LaneNotes hit = notes & hidden;
+            const LaneNotes is_hit = (LaneNotes)(hit != 0);
+            const LaneNotes updated = (hit & is_hit) | (notes & ~is_hit);
+            changed |= updated ^ notes;
+            cells[unit_cells[k]] = updated;
+        }
+    }
+
+    flags->bad = bad;
+    flags->unsolved = unsolved;
+    flags->changed = changed;
+}
+
+typedef void (*LockstepRound)(LaneNotes cells[81], LaneFlags *flags);
+
+static void lockstep_round_generic(LaneNotes cells[81], LaneFlags *flags) {
+    lockstep_round_body(cells, flags);
+}
+
+#if LOCKSTEP_X86
+__attribute__((target("avx2")))
+static void lockstep_round_avx2(LaneNotes cells[81], LaneFlags *flags) {
+    lockstep_round_body(cells, flags);
+}
+#endif
+
+// See `resolve_scan_units` for why the atomics
+static LockstepRound resolved_round = NULL;
+static const char *resolved_version = NULL;
+
+static LockstepRound resolve_round() {
+    LockstepRound round = __atomic_load_n(&resolved_round, __ATOMIC_ACQUIRE);
+    if (round != NULL)
+    {
+        return round;
+    }
+
+    const char *version = "generic";
+    round = lockstep_round_generic;
+#if LOCKSTEP_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        version = "avx2";
+        round = lockstep_round_avx2;
+    }
+#endif
+    __atomic_store_n(&resolved_version, version, __ATOMIC_RELAXED);
+    __atomic_store_n(&resolved_round, round, __ATOMIC_RELEASE);
+    return round;
+}
+
+static unsigned long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/*
+ * Puts the givens of `board` in `lane`. Values out of range get no candidate at all, so the lane is bad
+ * in the first round and the board goes to the scalar solver, which reports them
+ */
+static void load_lane(LaneNotes cells[81], unsigned short int lane, unsigned short int board[9][9]) {
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const unsigned short int n = board[cell / 9][cell % 9];
+        cells[cell][lane] = n == 0 ? NOTES_ALL_VALUES : n <= 9 ? NOTES_BIT(n) : 0;
+    }
+}
+
+static void clear_lane(LaneNotes cells[81], unsigned short int lane) {
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        cells[cell][lane] = NOTES_ALL_VALUES;
+    }
+}
+
+/*
+ * Finishes the board of a stalled lane in the scalar solver, from the candidates of the lane
+ * Return 0 if the board has no solution, >0 otherwise
+ */
+static int solve_lane(SudokuSolver *solver, const LaneNotes cells[81], unsigned short int lane,
+                      unsigned short int input[9][9], unsigned short int output[9][9]) {
+    Notes candidates[81];
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        candidates[cell] = cells[cell][lane];
+    }
+
+    // Unsolvable boards are solved again from their givens, so `output` is the partial board `sudoku_solver_solve` leaves
+    return solve_from_candidates(solver, candidates, output) || sudoku_solver_solve(solver, input, output);
+}
+
+// -- PUBLIC -- //
+size_t sudoku_lockstep_solve(SudokuBoard *inputs, SudokuBoard *outputs, unsigned char *solved,
+                             unsigned long long *finished_ns, size_t count)
+{
+    const LockstepRound round = resolve_round();
+    SudokuSolver solver;
+    LaneNotes cells[81];
+    size_t lane_board[SUDOKU_LOCKSTEP_LANES];
+    size_t next = 0, busy = 0, solved_count = 0;
+
+    for (unsigned short int lane = 0; lane < SUDOKU_LOCKSTEP_LANES; lane++)
+    {
+        if (next < count)
+        {
+            lane_board[lane] = next;
+            load_lane(cells, lane, inputs[next++]);
+            busy++;
+        }
+        else
+        {
+            lane_board[lane] = NO_BOARD;
+            clear_lane(cells, lane);
+        }
+    }
+
+    while (busy > 0)
+    {
+        LaneFlags flags;
+        round(cells, &flags);
+
+        for (unsigned short int lane = 0; lane < SUDOKU_LOCKSTEP_LANES; lane++)
+        {
+            const size_t k = lane_board[lane];
+            if (k == NO_BOARD)
+            {
+                continue;
+            }
+
+            int is_solved;
+            if (flags.bad[lane])
+            {
+                is_solved = sudoku_solver_solve(&solver, inputs[k], outputs[k]) != 0;
+            }
+            else if (!flags.unsolved[lane])
+            {
+                // The round only checked the board, so the cells still hold the values it started with
+                for (unsigned short int cell = 0; cell < 81; cell++)
+                {
+                    outputs[k][cell / 9][cell % 9] = __builtin_ctz(cells[cell][lane]) + 1;
+                }
+                is_solved = 1;
+            }
+            else if (!flags.changed[lane])
+            {
+                is_solved = solve_lane(&solver, cells, lane, inputs[k], outputs[k]) != 0;
+            }
+            else
+            {
+                continue;
+            }
+
+            if (solved != NULL)
+            {
+                solved[k] = is_solved;
+            }
+            if (finished_ns != NULL)
+            {
+                finished_ns[k] = now_ns();
+            }
+            solved_count += is_solved;
+
+            if (next < count)
+            {
+                lane_board[lane] = next;
+                load_lane(cells, lane, inputs[next++]);
+            }
+            else
+            {
+                lane_board[lane] = NO_BOARD;
+                clear_lane(cells, lane);
+                busy--;
+            }
+        }
+    }
+    return solved_count;
+}
+
+const char *sudoku_lockstep_version() {
+    resolve_round();
+    return __atomic_load_n(&resolved_version, __ATOMIC_RELAXED);
+}
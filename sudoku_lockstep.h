@@ -0,0 +1,27 @@
+#ifndef SUDOKU_LOCKSTEP_H
+#define SUDOKU_LOCKSTEP_H
+
+#include <stddef.h>
+#include "sudoku_batch.h"
+
+// Boards solved side by side, one per 16 bit lane: a 256 bit register with AVX2, two 128 bit ones with SSE2
+#define SUDOKU_LOCKSTEP_LANES 16
+
+/*
+ * Solves `count` boards from `inputs` into `outputs` (and `solved`, if not NULL) on the calling thread,
+ * SUDOKU_LOCKSTEP_LANES boards at a time. `finished_ns` (if not NULL) gets the CLOCK_MONOTONIC time, in
+ * nanoseconds, at which each board was done, so that boards solved together still get a latency of their own
+ * The candidates of the boards are kept structure of arrays, one vector of lanes per cell, and every round applies
+ * naked and hidden singles to all the lanes at once. A lane whose board is solved takes the next board of `inputs`.
+ * A board the singles cannot finish carries on alone in the scalar solver, from the candidates the lanes left, so
+ * the results are the same as `sudoku_solver_solve` board by board. Pays off on boards the singles solve,
+ * the easy and medium ones
+ * Return the number of boards that were fully solved
+ */
+size_t sudoku_lockstep_solve(SudokuBoard *inputs, SudokuBoard *outputs, unsigned char *solved,
+                             unsigned long long *finished_ns, size_t count);
+
+// Name of the instruction set the lanes run on: "avx2" or "generic"
+const char *sudoku_lockstep_version();
+
+#endif // SUDOKU_LOCKSTEP_H
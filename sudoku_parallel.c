@@ -0,0 +1,320 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "sudoku_parallel.h"
+#include "sudoku_batch.h"
+#include "sudoku_solver_internal.h"
+
+// Tasks each thread can have waiting, pushing stops there and the thread searches the rest itself
+#define POOL_QUEUE_TASKS 64
+
+/*
+ * Tasks waiting in the queue of one thread, a ring of `count` tasks from `head`
+ * The owner takes the newest (the deepest), thieves take the oldest
+ */
+typedef struct TaskQueue {
+    pthread_mutex_t lock;
+    unsigned char *tasks;
+    size_t head;
+    size_t count;
+} TaskQueue;
+
+struct SudokuSearchPool {
+    SudokuSearchTask search;
+    void *context;
+    size_t task_size;
+    unsigned int threads;
+    TaskQueue *queues;
+    // Tasks queued or being searched, the search is over once none is left
+    size_t unfinished;
+    // Threads waiting for a task
+    unsigned int idle;
+    int stopped;
+    // Taken by threads that wait for a task, woken up whenever one is pushed or the search ends
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+typedef struct PoolWorker {
+    SudokuSearchPool *pool;
+    unsigned int id;
+    // The task being searched, copied out of its queue
+    unsigned char *task;
+} PoolWorker;
+
+static unsigned char *queue_slot(const SudokuSearchPool *pool, const TaskQueue *queue, size_t k) {
+    return queue->tasks + ((queue->head + k) % POOL_QUEUE_TASKS) * pool->task_size;
+}
+
+/*
+ * Copies the newest task of the own queue of `worker`, or else the oldest of another queue, into `task`
+ * Return 0 if every queue is empty, >0 otherwise
+ */
+static int take_task(SudokuSearchPool *pool, unsigned int worker, unsigned char *task) {
+    for (unsigned int k = 0; k < pool->threads; k++)
+    {
+        TaskQueue *queue = &pool->queues[(worker + k) % pool->threads];
+        pthread_mutex_lock(&queue->lock);
+        const size_t count = queue->count;
+        if (count > 0)
+        {
+            if (k == 0)
+            {
+                memcpy(task, queue_slot(pool, queue, count - 1), pool->task_size);
+            }
+            else
+            {
+                memcpy(task, queue_slot(pool, queue, 0), pool->task_size);
+                queue->head = (queue->head + 1) % POOL_QUEUE_TASKS;
+            }
+            __atomic_store_n(&queue->count, count - 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&queue->lock);
+        if (count > 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int has_tasks(SudokuSearchPool *pool) {
+    for (unsigned int k = 0; k < pool->threads; k++)
+    {
+        if (__atomic_load_n(&pool->queues[k].count, __ATOMIC_RELAXED) > 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void wake_all(SudokuSearchPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void *pool_worker_run(void *arg) {
+    PoolWorker *worker = arg;
+    SudokuSearchPool *pool = worker->pool;
+    for (;;)
+    {
+        if (take_task(pool, worker->id, worker->task))
+        {
+            if (!sudoku_search_pool_stopped(pool))
+            {
+                pool->search(pool, worker->id, worker->task, pool->context);
+            }
+            if (__atomic_sub_fetch(&pool->unfinished, 1, __ATOMIC_ACQ_REL) == 0)
+            {
+                wake_all(pool);
+            }
+            continue;
+        }
+
+        // Pushes count the task as unfinished before queueing it, and wake the waiting threads after
+        pthread_mutex_lock(&pool->lock);
+        __atomic_add_fetch(&pool->idle, 1, __ATOMIC_RELAXED);
+        while (!sudoku_search_pool_stopped(pool) && __atomic_load_n(&pool->unfinished, __ATOMIC_ACQUIRE) > 0
+               && !has_tasks(pool))
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        __atomic_sub_fetch(&pool->idle, 1, __ATOMIC_RELAXED);
+        const int done = sudoku_search_pool_stopped(pool) || __atomic_load_n(&pool->unfinished, __ATOMIC_ACQUIRE) == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (done)
+        {
+            return NULL;
+        }
+    }
+}
+
+typedef struct ParallelSolve {
+    unsigned short int (*output)[9];
+    int solved;
+} ParallelSolve;
+
+// Placed cells of `solver`, 0 for the others, like `sudoku_solver_solve` writes its output
+static void write_board(const SudokuSolver *solver, unsigned short int output[9][9]) {
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const Notes notes = solver->candidates[cell / 9][cell % 9];
+        output[cell / 9][cell % 9] = is_cell_unsolved(solver, cell) ? 0 : __builtin_ctz(notes) + 1;
+    }
+}
+
+/*
+ * Depth first search like `search`, except that while another thread is idle the branches not taken yet are pushed
+ * for it instead of being searched here
+ * Return 0 if there is no solution from this state or another thread found one first, >0 otherwise
+ */
+static int parallel_search(SudokuSearchPool *pool, unsigned int worker, SudokuSolver *solver, ParallelSolve *result) {
+    if (sudoku_search_pool_stopped(pool) || !propagate_singles(solver))
+    {
+        return 0;
+    }
+
+    const unsigned short int cell = pick_search_cell(solver);
+    if (cell == 81)
+    {
+        if (!sudoku_search_pool_stop(pool))
+        {
+            return 0;
+        }
+        write_board(solver, result->output);
+        result->solved = 1;
+        return 1;
+    }
+
+    const unsigned short int i = cell / 9, j = cell % 9;
+    for (Notes options = solver->candidates[i][j]; options != 0; options &= options - 1)
+    {
+        SudokuSolver guess = *solver;
+        handle_number_in_cell(&guess, __builtin_ctz(options) + 1, i, j);
+        // The last branch is always kept, it is the one this thread goes on with
+        if ((options & (options - 1)) != 0 && sudoku_search_pool_hungry(pool, worker)
+            && sudoku_search_pool_push(pool, worker, &guess))
+        {
+            continue;
+        }
+        if (parallel_search(pool, worker, &guess, result))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void parallel_task(SudokuSearchPool *pool, unsigned int worker, void *task, void *context) {
+    parallel_search(pool, worker, task, context);
+}
+
+// -- PUBLIC -- //
+void sudoku_search_pool_run(const void *root, size_t task_size, SudokuSearchTask search, void *context,
+                            unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = sudoku_batch_default_threads();
+    }
+
+    SudokuSearchPool pool;
+    pool.search = search;
+    pool.context = context;
+    pool.task_size = task_size;
+    pool.threads = threads;
+    pool.unfinished = 1;
+    pool.idle = 0;
+    pool.stopped = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.wake, NULL);
+
+    pool.queues = calloc(threads, sizeof(*pool.queues));
+    PoolWorker *workers = calloc(threads, sizeof(*workers));
+    pthread_t *thread_ids = malloc(threads * sizeof(*thread_ids));
+    unsigned char *started = calloc(threads, 1);
+    assert(pool.queues != NULL && workers != NULL && thread_ids != NULL && started != NULL
+           && "Out of memory for the search pool");
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        pthread_mutex_init(&pool.queues[t].lock, NULL);
+        pool.queues[t].tasks = malloc(POOL_QUEUE_TASKS * task_size);
+        workers[t].pool = &pool;
+        workers[t].id = t;
+        workers[t].task = malloc(task_size);
+        assert(pool.queues[t].tasks != NULL && workers[t].task != NULL && "Out of memory for tasks");
+    }
+    memcpy(pool.queues[0].tasks, root, task_size);
+    pool.queues[0].count = 1;
+
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        started[t] = pthread_create(&thread_ids[t], NULL, pool_worker_run, &workers[t]) == 0;
+    }
+    pool_worker_run(&workers[0]);
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(thread_ids[t], NULL);
+        }
+    }
+
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        pthread_mutex_destroy(&pool.queues[t].lock);
+        free(pool.queues[t].tasks);
+        free(workers[t].task);
+    }
+    pthread_cond_destroy(&pool.wake);
+    pthread_mutex_destroy(&pool.lock);
+    free(started);
+    free(thread_ids);
+    free(workers);
+    free(pool.queues);
+}
+
+int sudoku_search_pool_hungry(const SudokuSearchPool *pool, unsigned int worker) {
+    return __atomic_load_n(&pool->idle, __ATOMIC_RELAXED) > 0
+           && __atomic_load_n(&pool->queues[worker].count, __ATOMIC_RELAXED) == 0;
+}
+
+int sudoku_search_pool_push(SudokuSearchPool *pool, unsigned int worker, const void *task) {
+    TaskQueue *queue = &pool->queues[worker];
+    pthread_mutex_lock(&queue->lock);
+    const int pushed = queue->count < POOL_QUEUE_TASKS;
+    if (pushed)
+    {
+        __atomic_add_fetch(&pool->unfinished, 1, __ATOMIC_ACQ_REL);
+        memcpy(queue_slot(pool, queue, queue->count), task, pool->task_size);
+        __atomic_store_n(&queue->count, queue->count + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    if (pushed)
+    {
+        wake_all(pool);
+    }
+    return pushed;
+}
+
+int sudoku_search_pool_stop(SudokuSearchPool *pool) {
+    const int first = __atomic_exchange_n(&pool->stopped, 1, __ATOMIC_ACQ_REL) == 0;
+    if (first)
+    {
+        wake_all(pool);
+    }
+    return first;
+}
+
+int sudoku_search_pool_stopped(const SudokuSearchPool *pool) {
+    return __atomic_load_n(&pool->stopped, __ATOMIC_ACQUIRE);
+}
+
+int sudoku_parallel_solve(unsigned short int input[9][9], unsigned short int output[9][9], unsigned int threads) {
+    SudokuSolver solver;
+    sudoku_solver_init(&solver);
+    ParallelSolve result = { output, 0 };
+    if (place_givens(&solver, input) && propagate_singles(&solver))
+    {
+        if (pick_search_cell(&solver) != 81)
+        {
+            sudoku_search_pool_run(&solver, sizeof(solver), parallel_task, &result, threads);
+            if (result.solved)
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            result.solved = 1;
+        }
+    }
+
+    // Without a solution the board is left as far as the givens and the singles took it, like the serial search does
+    write_board(&solver, output);
+    return result.solved;
+}
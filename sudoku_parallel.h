@@ -0,0 +1,61 @@
+#ifndef SUDOKU_PARALLEL_H
+#define SUDOKU_PARALLEL_H
+
+#include <stddef.h>
+
+/*
+ * Search of a single puzzle spread over threads, for the puzzles hard enough that their own latency matters
+ * Every thread searches depth first on its own. While a thread has nothing to do, the busy ones put the branches
+ * they have not started yet in their own queue instead of searching them later, and the idle thread steals the
+ * oldest of them, which are the closest to the root and so the biggest. Nothing is copied while every thread is busy.
+ * The first solution found stops all the threads
+ */
+
+typedef struct SudokuSearchPool SudokuSearchPool;
+
+/*
+ * Searches from `task`, one of the tasks of `pool`, on thread `worker`. The task belongs to the worker until the
+ * function returns, so it can be searched in place
+ */
+typedef void (*SudokuSearchTask)(SudokuSearchPool *pool, unsigned int worker, void *task, void *context);
+
+/*
+ * Runs `search` on `root` (`task_size` bytes) and on every task pushed while it runs, on `threads` threads
+ * (0 for one per core). The calling thread is one of them, so the search completes even if no thread can be started
+ * Returns once every task is done or the search was stopped
+ */
+void sudoku_search_pool_run(const void *root, size_t task_size, SudokuSearchTask search, void *context,
+                            unsigned int threads);
+
+/*
+ * Return >0 if a thread is waiting for work and the queue of `worker` is empty, so a branch is worth pushing,
+ * 0 otherwise
+ */
+int sudoku_search_pool_hungry(const SudokuSearchPool *pool, unsigned int worker);
+
+/*
+ * Copies `task` into the queue of `worker`, where any thread can take it
+ * Return 0 if the queue is full, in which case the caller searches it itself, >0 otherwise
+ */
+int sudoku_search_pool_push(SudokuSearchPool *pool, unsigned int worker, const void *task);
+
+/*
+ * Stops the search: tasks not started yet are dropped, and searches in progress should return as soon as they see
+ * `sudoku_search_pool_stopped`
+ * Return >0 for the first caller only, which found the result, 0 otherwise
+ */
+int sudoku_search_pool_stop(SudokuSearchPool *pool);
+
+/*
+ * Return >0 once the search was stopped, 0 otherwise
+ */
+int sudoku_search_pool_stopped(const SudokuSearchPool *pool);
+
+/*
+ * Solves `input` into `output` like `sudoku_solver_solve`, with the guessing spread over `threads` threads (0 for
+ * one per core). Boards solved without guessing don't start any thread
+ * Return 0 if the board has no solution, >0 otherwise. Cells that could not be solved are left at 0 in `output`
+ */
+int sudoku_parallel_solve(unsigned short int input[9][9], unsigned short int output[9][9], unsigned int threads);
+
+#endif // SUDOKU_PARALLEL_H
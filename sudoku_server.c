@@ -0,0 +1,639 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "sudoku_server.h"
+#include "sudoku_lockstep.h"
+#include "sudoku_count.h"
+#include "sudoku_io.h"
+#include "sudoku_util.h"
+
+// Longest request line a connection may send, longer ones close it
+#define SERVER_INPUT_SIZE 4096
+// A connection whose client stops reading its responses is not read from until this much of them is sent
+#define SERVER_OUTPUT_LIMIT (1 << 20)
+// Responses are at most "ok " and a board
+#define SERVER_RESPONSE_LENGTH 85
+
+typedef enum RequestKind {
+    REQUEST_SOLVE,
+    REQUEST_COUNT,
+    REQUEST_INVALID
+} RequestKind;
+
+typedef struct Connection {
+    int fd;
+    // Set once the client has hung up or misbehaved, the connection is closed once its responses are sent
+    int closing;
+    unsigned long long read_ns;
+    char input[SERVER_INPUT_SIZE];
+    size_t input_used;
+    // Start of the lines not taken as requests yet
+    size_t input_parsed;
+    char *output;
+    size_t output_used;
+    size_t output_sent;
+    size_t output_capacity;
+} Connection;
+
+typedef struct Request {
+    Connection *connection;
+    RequestKind kind;
+    unsigned long long start_ns;
+    // When its response was ready, for solve requests the moment the lane of its board was done
+    unsigned long long done_ns;
+    // Index of its board among the solve requests of the batch
+    size_t board;
+    unsigned long long solutions;
+    int ok;
+} Request;
+
+typedef struct ServerWorker {
+    int listen_fd;
+    int stop_fd;
+    Connection **connections;
+    size_t connection_count;
+    size_t connection_capacity;
+    struct pollfd *polls;
+    Request requests[SUDOKU_SERVER_BATCH];
+    SudokuBoard inputs[SUDOKU_SERVER_BATCH];
+    SudokuBoard outputs[SUDOKU_SERVER_BATCH];
+    unsigned char solved[SUDOKU_SERVER_BATCH];
+    unsigned long long finished_ns[SUDOKU_SERVER_BATCH];
+    SudokuBatchStats stats;
+} ServerWorker;
+
+// Written to by the signal handler, every worker polls the other end and stops once it is readable
+static int stop_pipe[2] = {-1, -1};
+
+static void request_stop(int signal) {
+    (void)signal;
+    const char byte = 0;
+    const ssize_t written = write(stop_pipe[1], &byte, 1);
+    (void)written;
+}
+
+static unsigned long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int set_nonblocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static int fill_address(struct sockaddr_un *address, const char *path) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return 0;
+    }
+    strcpy(address->sun_path, path);
+    return 1;
+}
+
+static void add_connection(ServerWorker *worker, int fd) {
+    if (worker->connection_count == worker->connection_capacity)
+    {
+        worker->connection_capacity = worker->connection_capacity > 0 ? 2 * worker->connection_capacity : 16;
+        worker->connections = realloc(worker->connections, worker->connection_capacity * sizeof(*worker->connections));
+        // The listening socket and the stop pipe come first
+        worker->polls = realloc(worker->polls, (worker->connection_capacity + 2) * sizeof(*worker->polls));
+        assert(worker->connections != NULL && worker->polls != NULL && "Out of memory for connections");
+    }
+
+    Connection *connection = calloc(1, sizeof(*connection));
+    assert(connection != NULL && "Out of memory for connections");
+    connection->fd = fd;
+    worker->connections[worker->connection_count++] = connection;
+}
+
+static void close_connection(ServerWorker *worker, size_t k) {
+    Connection *connection = worker->connections[k];
+    close(connection->fd);
+    free(connection->output);
+    free(connection);
+    worker->connections[k] = worker->connections[--worker->connection_count];
+}
+
+static void accept_connections(ServerWorker *worker) {
+    for (;;)
+    {
+        const int fd = accept(worker->listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            // Another worker got it first, or nothing is left to accept
+            return;
+        }
+        if (!set_nonblocking(fd))
+        {
+            close(fd);
+            continue;
+        }
+        add_connection(worker, fd);
+    }
+}
+
+/*
+ * Reads whatever the client has sent into the input buffer of `connection`
+ */
+static void read_connection(Connection *connection) {
+    if (connection->input_parsed > 0)
+    {
+        connection->input_used -= connection->input_parsed;
+        memmove(connection->input, connection->input + connection->input_parsed, connection->input_used);
+        connection->input_parsed = 0;
+    }
+
+    while (connection->input_used < SERVER_INPUT_SIZE)
+    {
+        const ssize_t bytes = read(connection->fd, connection->input + connection->input_used,
+                                   SERVER_INPUT_SIZE - connection->input_used);
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        if (bytes <= 0)
+        {
+            connection->closing = 1;
+            break;
+        }
+        connection->input_used += bytes;
+        connection->read_ns = now_ns();
+    }
+
+    // Nothing in there ends a line, so it can't become a request
+    if (connection->input_used == SERVER_INPUT_SIZE && memchr(connection->input, '\n', SERVER_INPUT_SIZE) == NULL)
+    {
+        connection->input_used = 0;
+        connection->closing = 1;
+    }
+}
+
+static void append_output(Connection *connection, const char *data, size_t length) {
+    if (connection->output_capacity - connection->output_used < length)
+    {
+        connection->output_capacity = connection->output_capacity > 0 ? 2 * connection->output_capacity : 4096;
+        while (connection->output_capacity - connection->output_used < length)
+        {
+            connection->output_capacity *= 2;
+        }
+        connection->output = realloc(connection->output, connection->output_capacity);
+        assert(connection->output != NULL && "Out of memory for responses");
+    }
+    memcpy(connection->output + connection->output_used, data, length);
+    connection->output_used += length;
+}
+
+/*
+ * Sends as much of the pending responses of `connection` as the socket takes
+ */
+static void flush_connection(Connection *connection) {
+    while (connection->output_sent < connection->output_used)
+    {
+        const ssize_t bytes = send(connection->fd, connection->output + connection->output_sent,
+                                   connection->output_used - connection->output_sent, MSG_NOSIGNAL);
+        if (bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return;
+        }
+        if (bytes <= 0)
+        {
+            // The client is gone, nobody is waiting for the rest
+            connection->closing = 1;
+            connection->output_sent = connection->output_used;
+            break;
+        }
+        connection->output_sent += bytes;
+    }
+    connection->output_sent = 0;
+    connection->output_used = 0;
+}
+
+/*
+ * Takes the next complete line of `connection` as a request into `request` (and its board into `board`)
+ * Return 0 if no complete line is left, >0 otherwise
+ */
+static int parse_request(Connection *connection, Request *request, unsigned short int board[9][9]) {
+    const char *start = connection->input + connection->input_parsed;
+    const char *newline = memchr(start, '\n', connection->input_used - connection->input_parsed);
+    if (newline == NULL)
+    {
+        return 0;
+    }
+    size_t length = newline - start;
+    connection->input_parsed += length + 1;
+    if (length > 0 && start[length - 1] == '\r')
+    {
+        length--;
+    }
+
+    request->connection = connection;
+    request->start_ns = connection->read_ns;
+    request->kind = REQUEST_SOLVE;
+    if (length > 6 && strncmp(start, "solve ", 6) == 0)
+    {
+        start += 6;
+        length -= 6;
+    }
+    else if (length > 6 && strncmp(start, "count ", 6) == 0)
+    {
+        request->kind = REQUEST_COUNT;
+        start += 6;
+        length -= 6;
+    }
+    if (length != 81 || !parse_sudoku_line(start, board))
+    {
+        request->kind = REQUEST_INVALID;
+    }
+    return 1;
+}
+
+/*
+ * Takes up to SUDOKU_SERVER_BATCH requests from the connections of `worker`, solves them and queues their responses
+ * Return the number of requests handled, 0 if no connection had a complete line
+ */
+static size_t handle_batch(ServerWorker *worker) {
+    size_t count = 0, boards = 0;
+    for (size_t k = 0; k < worker->connection_count && count < SUDOKU_SERVER_BATCH; k++)
+    {
+        Connection *connection = worker->connections[k];
+        if (connection->output_used > SERVER_OUTPUT_LIMIT)
+        {
+            continue;
+        }
+        while (count < SUDOKU_SERVER_BATCH && parse_request(connection, &worker->requests[count], worker->inputs[boards]))
+        {
+            worker->requests[count].board = boards;
+            boards += worker->requests[count].kind != REQUEST_INVALID;
+            count++;
+        }
+    }
+
+    // Solve requests that arrived together go through the lanes together, count requests one by one
+    size_t solve_count = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        Request *request = &worker->requests[k];
+        if (request->kind == REQUEST_SOLVE)
+        {
+            if (request->board != solve_count)
+            {
+                memcpy(worker->inputs[solve_count], worker->inputs[request->board], sizeof(SudokuBoard));
+                request->board = solve_count;
+            }
+            solve_count++;
+        }
+        else if (request->kind == REQUEST_COUNT)
+        {
+            request->solutions = sudoku_count_solutions(worker->inputs[request->board], 2, 1);
+        }
+        request->done_ns = now_ns();
+    }
+    sudoku_lockstep_solve(worker->inputs, worker->outputs, worker->solved, worker->finished_ns, solve_count);
+
+    char response[SERVER_RESPONSE_LENGTH];
+    for (size_t k = 0; k < count; k++)
+    {
+        Request *request = &worker->requests[k];
+        int length;
+        if (request->kind == REQUEST_SOLVE)
+        {
+            request->done_ns = worker->finished_ns[request->board];
+        }
+        if (request->kind == REQUEST_SOLVE && worker->solved[request->board])
+        {
+            memcpy(response, "ok ", 3);
+            format_sudoku_line(worker->outputs[request->board], response + 3);
+            response[84] = '\n';
+            length = 85;
+        }
+        else if (request->kind == REQUEST_SOLVE)
+        {
+            length = sprintf(response, "none\n");
+        }
+        else if (request->kind == REQUEST_COUNT)
+        {
+            length = sprintf(response, "ok %llu\n", request->solutions);
+        }
+        else
+        {
+            length = sprintf(response, "error not a request\n");
+        }
+        request->ok = response[0] == 'o';
+        append_output(request->connection, response, length);
+    }
+    return count;
+}
+
+/*
+ * Sends the responses of the last batches, and records the latency of every request of the batch, up to the moment
+ * its own response was ready
+ */
+static void flush_batch(ServerWorker *worker, size_t count) {
+    for (size_t k = 0; k < worker->connection_count; k++)
+    {
+        flush_connection(worker->connections[k]);
+    }
+
+    for (size_t k = 0; k < count; k++)
+    {
+        const Request *request = &worker->requests[k];
+        sudoku_batch_stats_record(&worker->stats, request->done_ns - request->start_ns, request->ok);
+    }
+}
+
+static void *server_worker_run(void *arg) {
+    ServerWorker *worker = arg;
+    worker->polls = malloc(2 * sizeof(*worker->polls));
+    assert(worker->polls != NULL && "Out of memory for connections");
+
+    for (;;)
+    {
+        worker->polls[0] = (struct pollfd){ worker->listen_fd, POLLIN, 0 };
+        worker->polls[1] = (struct pollfd){ worker->stop_fd, POLLIN, 0 };
+        for (size_t k = 0; k < worker->connection_count; k++)
+        {
+            const Connection *connection = worker->connections[k];
+            // Nothing more is read from clients that hung up, or that don't read their responses
+            short events = 0;
+            if (!connection->closing && connection->output_used <= SERVER_OUTPUT_LIMIT
+                && connection->input_used - connection->input_parsed < SERVER_INPUT_SIZE)
+            {
+                events |= POLLIN;
+            }
+            if (connection->output_used > connection->output_sent)
+            {
+                events |= POLLOUT;
+            }
+            worker->polls[k + 2] = (struct pollfd){ connection->fd, events, 0 };
+        }
+
+        if (poll(worker->polls, worker->connection_count + 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if (worker->polls[1].revents != 0)
+        {
+            break;
+        }
+
+        // Connections accepted now are polled from the next round on
+        const size_t polled = worker->connection_count;
+        if (worker->polls[0].revents != 0)
+        {
+            accept_connections(worker);
+        }
+        for (size_t k = 0; k < polled; k++)
+        {
+            if ((worker->polls[k + 2].revents & (POLLIN | POLLHUP | POLLERR)) && !worker->connections[k]->closing)
+            {
+                read_connection(worker->connections[k]);
+            }
+        }
+
+        // Everything read this round is answered before polling again, a batch at a time
+        size_t count;
+        do
+        {
+            count = handle_batch(worker);
+            flush_batch(worker, count);
+        } while (count == SUDOKU_SERVER_BATCH);
+
+        for (size_t k = worker->connection_count; k-- > 0;)
+        {
+            const Connection *connection = worker->connections[k];
+            if (connection->closing && connection->output_used == connection->output_sent)
+            {
+                close_connection(worker, k);
+            }
+        }
+    }
+
+    while (worker->connection_count > 0)
+    {
+        close_connection(worker, worker->connection_count - 1);
+    }
+    free(worker->connections);
+    free(worker->polls);
+    return NULL;
+}
+
+// -- PUBLIC -- //
+int sudoku_server_run(const char *path, unsigned int threads, SudokuBatchStats *stats) {
+    if (threads == 0)
+    {
+        threads = sudoku_batch_default_threads();
+    }
+
+    struct sockaddr_un address;
+    if (!fill_address(&address, path))
+    {
+        return 0;
+    }
+    const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+        return 0;
+    }
+    // Only a socket left by an earlier run is replaced, anything else at `path` is somebody's file
+    struct stat existing;
+    if (lstat(path, &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+            close(listen_fd);
+            errno = EEXIST;
+            return 0;
+        }
+        unlink(path);
+    }
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, SOMAXCONN) != 0
+        || !set_nonblocking(listen_fd) || pipe(stop_pipe) != 0)
+    {
+        close(listen_fd);
+        return 0;
+    }
+
+    struct sigaction action, old_interrupt, old_terminate;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &old_interrupt);
+    sigaction(SIGTERM, &action, &old_terminate);
+
+    ServerWorker *workers = calloc(threads, sizeof(*workers));
+    pthread_t *thread_ids = malloc(threads * sizeof(*thread_ids));
+    unsigned char *started = calloc(threads, 1);
+    assert(workers != NULL && thread_ids != NULL && started != NULL && "Out of memory for workers");
+
+    const unsigned long long start = now_ns();
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        workers[t].listen_fd = listen_fd;
+        workers[t].stop_fd = stop_pipe[0];
+        sudoku_batch_stats_init(&workers[t].stats);
+    }
+    // Thread 0 is the calling thread, the others only share the accepting, so any of them may fail to start
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        started[t] = pthread_create(&thread_ids[t], NULL, server_worker_run, &workers[t]) == 0;
+    }
+    server_worker_run(&workers[0]);
+
+    SudokuBatchStats total;
+    sudoku_batch_stats_init(&total);
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        if (t > 0 && started[t])
+        {
+            pthread_join(thread_ids[t], NULL);
+        }
+        sudoku_batch_stats_merge(&total, &workers[t].stats);
+    }
+    total.threads = threads;
+    total.seconds = (now_ns() - start) / 1e9;
+    if (stats != NULL)
+    {
+        *stats = total;
+    }
+
+    sigaction(SIGINT, &old_interrupt, NULL);
+    sigaction(SIGTERM, &old_terminate, NULL);
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    stop_pipe[0] = stop_pipe[1] = -1;
+    close(listen_fd);
+    unlink(path);
+    free(started);
+    free(thread_ids);
+    free(workers);
+    return 1;
+}
+
+int sudoku_server_query(const char *path, const char *input, int count, size_t window, SudokuBatchStats *stats) {
+    struct sockaddr_un address;
+    if (!fill_address(&address, path))
+    {
+        return 0;
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    SudokuReader reader;
+    if (!sudoku_reader_open(&reader, input))
+    {
+        close(fd);
+        return 0;
+    }
+    if (window == 0)
+    {
+        window = 1;
+    }
+    // The server stops reading once more than SERVER_OUTPUT_LIMIT of responses wait for us, and we only read them
+    // once the whole window is sent, so a bigger window would leave both sides waiting for good
+    if (window > SERVER_OUTPUT_LIMIT / SERVER_RESPONSE_LENGTH)
+    {
+        window = SERVER_OUTPUT_LIMIT / SERVER_RESPONSE_LENGTH;
+    }
+
+    // Requests are sent a window at a time, and the window's responses read before sending the next one
+    const size_t request_length = count ? 88 : 82;
+    char *requests = malloc(window * request_length);
+    char response[SERVER_RESPONSE_LENGTH + 1];
+    assert(requests != NULL && "Out of memory for requests");
+    SudokuBatchStats total;
+    sudoku_batch_stats_init(&total);
+    total.threads = 1;
+
+    const unsigned long long start = now_ns();
+    unsigned short int board[9][9];
+    FILE *responses = fdopen(dup(fd), "r");
+    int ok = responses != NULL;
+    size_t in_window;
+    do
+    {
+        in_window = 0;
+        while (ok && in_window < window && sudoku_reader_next(&reader, board))
+        {
+            char *request = requests + in_window * request_length;
+            if (count)
+            {
+                memcpy(request, "count ", 6);
+            }
+            format_sudoku_line(board, request + request_length - 82);
+            request[request_length - 1] = '\n';
+            in_window++;
+        }
+
+        const unsigned long long sent = now_ns();
+        for (size_t offset = 0, total_length = in_window * request_length; ok && offset < total_length;)
+        {
+            const ssize_t bytes = send(fd, requests + offset, total_length - offset, MSG_NOSIGNAL);
+            if (bytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            ok = bytes > 0;
+            offset += ok ? (size_t)bytes : 0;
+        }
+        for (size_t k = 0; ok && k < in_window; k++)
+        {
+            ok = fgets(response, sizeof(response), responses) != NULL;
+            if (ok)
+            {
+                fputs(response, stdout);
+                sudoku_batch_stats_record(&total, now_ns() - sent, strncmp(response, "ok", 2) == 0);
+            }
+        }
+    } while (ok && in_window == window);
+    total.seconds = (now_ns() - start) / 1e9;
+    if (stats != NULL)
+    {
+        *stats = total;
+    }
+
+    if (responses != NULL)
+    {
+        fclose(responses);
+    }
+    free(requests);
+    sudoku_reader_close(&reader);
+    close(fd);
+    return ok;
+}
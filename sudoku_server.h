@@ -0,0 +1,44 @@
+#ifndef SUDOKU_SERVER_H
+#define SUDOKU_SERVER_H
+
+#include "sudoku_batch.h"
+
+/*
+ * Line protocol of the solver daemon, one request per line and one response line per request, in the same order.
+ * Clients may send any number of requests without waiting for the responses (pipelining).
+ *
+ *   <puzzle>           solve it (81 characters, `.` or `0` for blanks, see `parse_sudoku_line`)
+ *   solve <puzzle>     same
+ *   count <puzzle>     count its solutions, stopping at 2: tells apart broken, unique and ambiguous puzzles
+ *
+ * Responses are `ok <solution>` or `none` for solve, `ok <0, 1 or 2>` for count,
+ * and `error <reason>` for lines that are not a request
+ */
+
+// Requests a worker takes at once, from all its connections, and solves together
+#define SUDOKU_SERVER_BATCH 256
+
+/*
+ * Listens on the Unix domain socket `path` and serves requests until SIGINT or SIGTERM, on `threads` worker threads
+ * (one per core if 0). Every worker owns the connections it accepts, its own solver state and its own buffers, so the
+ * workers never wait for each other. A worker reads everything its connections have sent, solves all the complete
+ * requests together (the solve requests side by side with `sudoku_lockstep_solve`), and writes every response of a
+ * connection with a single call.
+ * A socket already at `path`, left by an earlier run, is replaced, but any other file there makes the call fail
+ * (errno EEXIST) and is left as it was. Latencies in `stats` (if not NULL) go from reading a request to its response
+ * being ready, which for a solve request is when the lane of its board is done
+ * Return 0 if the socket could not be set up, >0 otherwise
+ */
+int sudoku_server_run(const char *path, unsigned int threads, SudokuBatchStats *stats);
+
+/*
+ * Client of `sudoku_server_run`: sends every puzzle of `input` (a file, or stdin if NULL) to the daemon at `path`
+ * as a solve request (or count request if `count` is set), keeping up to `window` requests in flight, and prints the
+ * responses to stdout in order. The window is capped at what the daemon keeps waiting for a connection (about 12000
+ * requests). Latencies in `stats` (if not NULL) are round trips, from sending a request to reading
+ * its response
+ * Return 0 if the daemon could not be reached or hung up, >0 otherwise
+ */
+int sudoku_server_query(const char *path, const char *input, int count, size_t window, SudokuBatchStats *stats);
+
+#endif // SUDOKU_SERVER_H
@@ -0,0 +1,322 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "sudoku_session.h"
+#include "sudoku_solver_internal.h"
+#include "sudoku_strategies.h"
+
+static void cell_units(unsigned short int cell, unsigned short int units[3]) {
+    units[0] = cell / 9;
+    units[1] = 9 + cell % 9;
+    units[2] = 18 + (cell / 27) * 3 + (cell % 9) / 3;
+}
+
+static int is_given(const SudokuSession *session, unsigned short int cell) {
+    return (session->givens[cell / 64] >> (cell % 64)) & 1;
+}
+
+static void add_value(SudokuSession *session, unsigned short int cell, unsigned short int n) {
+    unsigned short int units[3];
+    cell_units(cell, units);
+    for (unsigned short int k = 0; k < 3; k++)
+    {
+        const unsigned char count = ++session->counts[units[k]][n - 1];
+        session->used[units[k]] |= NOTES_BIT(n);
+        session->conflicts += count == 2;
+    }
+    session->values[cell] = (unsigned char)n;
+    session->filled++;
+}
+
+static void remove_value(SudokuSession *session, unsigned short int cell) {
+    const unsigned short int n = session->values[cell];
+    unsigned short int units[3];
+    cell_units(cell, units);
+    for (unsigned short int k = 0; k < 3; k++)
+    {
+        const unsigned char count = --session->counts[units[k]][n - 1];
+        if (count == 0)
+        {
+            session->used[units[k]] &= (Notes)~NOTES_BIT(n);
+        }
+        session->conflicts -= count == 1;
+    }
+    session->values[cell] = 0;
+    session->filled--;
+}
+
+static void set_value(SudokuSession *session, unsigned short int cell, unsigned short int n) {
+    if (session->values[cell] != 0)
+    {
+        remove_value(session, cell);
+    }
+    if (n != 0)
+    {
+        add_value(session, cell, n);
+    }
+}
+
+static Notes used_around(const SudokuSession *session, unsigned short int cell) {
+    unsigned short int units[3];
+    cell_units(cell, units);
+    return session->used[units[0]] | session->used[units[1]] | session->used[units[2]];
+}
+
+static void apply_move(SudokuSession *session, const SudokuMove *move, Notes state) {
+    if (move->is_mark)
+    {
+        session->marks[move->cell] = state;
+    }
+    else
+    {
+        set_value(session, move->cell, state);
+    }
+}
+
+/*
+ * Adds `move` to the journal, in place of the moves that were undone, and makes it
+ */
+static void record_move(SudokuSession *session, unsigned short int cell, int is_mark, Notes before, Notes after) {
+    if (session->journal_position == session->journal_capacity)
+    {
+        session->journal_capacity = session->journal_capacity > 0 ? 2 * session->journal_capacity : 64;
+        session->journal = realloc(session->journal, session->journal_capacity * sizeof(*session->journal));
+        assert(session->journal != NULL && "Out of memory for the journal");
+    }
+
+    SudokuMove *move = &session->journal[session->journal_position++];
+    move->cell = (unsigned char)cell;
+    move->is_mark = (unsigned char)is_mark;
+    move->before = before;
+    move->after = after;
+    session->journal_length = session->journal_position;
+    apply_move(session, move, after);
+}
+
+/*
+ * Looks for the easiest single on the candidates of `solver`: naked singles, then hidden singles in blocks,
+ * rows and columns, in order of their rating
+ * Return 0 if there is none, >0 otherwise with the single in `hint`
+ */
+static int find_single(const SudokuSolver *solver, SudokuHint *hint) {
+    const Notes *board = &solver->candidates[0][0];
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        if (is_cell_unsolved(solver, cell) && __builtin_popcount(board[cell]) == 1)
+        {
+            *hint = (SudokuHint){ SUDOKU_HINT_PLACE, SUDOKU_TECHNIQUE_NAKED_SINGLE, cell / 9, cell % 9,
+                                  __builtin_ctz(board[cell]) + 1 };
+            return 1;
+        }
+    }
+
+    static const unsigned short int unit_order[27] = {
+        18, 19, 20, 21, 22, 23, 24, 25, 26, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17
+    };
+    for (unsigned short int u = 0; u < 27; u++)
+    {
+        const unsigned short int unit = unit_order[u];
+        Notes seen_once = 0, seen_twice = 0;
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            const unsigned short int cell = sudoku_unit_cells[unit][k];
+            if (is_cell_unsolved(solver, cell))
+            {
+                seen_twice |= seen_once & board[cell];
+                seen_once |= board[cell];
+            }
+        }
+
+        const Notes singles = seen_once & (Notes)~seen_twice & unit_free_values(solver, unit);
+        if (singles == 0)
+        {
+            continue;
+        }
+        const unsigned short int n = __builtin_ctz(singles) + 1;
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            const unsigned short int cell = sudoku_unit_cells[unit][k];
+            if (is_cell_unsolved(solver, cell) && (board[cell] & NOTES_BIT(n)) != 0)
+            {
+                // Units are numbered rows, columns, blocks, in the same order as the hidden single techniques
+                *hint = (SudokuHint){ SUDOKU_HINT_PLACE, SUDOKU_TECHNIQUE_HIDDEN_SINGLE_ROW + unit / 9, cell / 9,
+                                      cell % 9, n };
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// -- PUBLIC -- //
+int sudoku_session_init(SudokuSession *session, unsigned short int puzzle[9][9]) {
+    memset(session, 0, sizeof(*session));
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const unsigned short int n = puzzle[cell / 9][cell % 9];
+        if (n > 9)
+        {
+            return 0;
+        }
+        if (n != 0)
+        {
+            session->givens[cell / 64] |= 1ull << (cell % 64);
+            add_value(session, cell, n);
+        }
+    }
+
+    SudokuSolver solver;
+    unsigned short int solution[9][9];
+    if (session->conflicts > 0 || !sudoku_solver_solve(&solver, puzzle, solution))
+    {
+        return 0;
+    }
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        session->solution[cell] = (unsigned char)solution[cell / 9][cell % 9];
+    }
+    return 1;
+}
+
+void sudoku_session_destroy(SudokuSession *session) {
+    free(session->journal);
+    memset(session, 0, sizeof(*session));
+}
+
+SudokuMoveStatus sudoku_session_check(const SudokuSession *session, unsigned short int row, unsigned short int column,
+                                      unsigned short int value)
+{
+    if (row >= 9 || column >= 9 || value > 9)
+    {
+        return SUDOKU_MOVE_REJECTED;
+    }
+    const unsigned short int cell = row * 9 + column;
+    if (is_given(session, cell) || session->values[cell] == value)
+    {
+        return SUDOKU_MOVE_REJECTED;
+    }
+    // The value the cell has now is not the one placed, so it can't be the one that conflicts
+    return value != 0 && (used_around(session, cell) & NOTES_BIT(value)) != 0 ? SUDOKU_MOVE_CONFLICT : SUDOKU_MOVE_OK;
+}
+
+SudokuMoveStatus sudoku_session_place(SudokuSession *session, unsigned short int row, unsigned short int column,
+                                      unsigned short int value)
+{
+    const SudokuMoveStatus status = sudoku_session_check(session, row, column, value);
+    if (status != SUDOKU_MOVE_REJECTED)
+    {
+        const unsigned short int cell = row * 9 + column;
+        record_move(session, cell, 0, session->values[cell], value);
+    }
+    return status;
+}
+
+SudokuMoveStatus sudoku_session_toggle_mark(SudokuSession *session, unsigned short int row, unsigned short int column,
+                                            unsigned short int value)
+{
+    if (row >= 9 || column >= 9 || value < 1 || value > 9 || session->values[row * 9 + column] != 0)
+    {
+        return SUDOKU_MOVE_REJECTED;
+    }
+    const unsigned short int cell = row * 9 + column;
+    const Notes before = session->marks[cell];
+    record_move(session, cell, 1, before, before ^ NOTES_BIT(value));
+    return (used_around(session, cell) & NOTES_BIT(value)) != 0 ? SUDOKU_MOVE_CONFLICT : SUDOKU_MOVE_OK;
+}
+
+Notes sudoku_session_candidates(const SudokuSession *session, unsigned short int row, unsigned short int column) {
+    assert(row < 9 && column < 9 && "Cell out of the board");
+    return NOTES_ALL_VALUES & (Notes)~used_around(session, row * 9 + column);
+}
+
+int sudoku_session_is_correct(const SudokuSession *session, unsigned short int row, unsigned short int column) {
+    assert(row < 9 && column < 9 && "Cell out of the board");
+    return session->values[row * 9 + column] == session->solution[row * 9 + column];
+}
+
+int sudoku_session_is_solved(const SudokuSession *session) {
+    return session->filled == 81 && session->conflicts == 0;
+}
+
+int sudoku_session_undo(SudokuSession *session) {
+    if (session->journal_position == 0)
+    {
+        return 0;
+    }
+    const SudokuMove *move = &session->journal[--session->journal_position];
+    apply_move(session, move, move->before);
+    return 1;
+}
+
+int sudoku_session_redo(SudokuSession *session) {
+    if (session->journal_position == session->journal_length)
+    {
+        return 0;
+    }
+    const SudokuMove *move = &session->journal[session->journal_position++];
+    apply_move(session, move, move->after);
+    return 1;
+}
+
+SudokuHint sudoku_session_hint(const SudokuSession *session) {
+    SudokuHint hint = { SUDOKU_HINT_NONE, SUDOKU_TECHNIQUE_NAKED_SINGLE, 0, 0, 0 };
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        if (session->values[cell] != 0 && session->values[cell] != session->solution[cell])
+        {
+            hint = (SudokuHint){ SUDOKU_HINT_MISTAKE, SUDOKU_TECHNIQUE_NAKED_SINGLE, cell / 9, cell % 9,
+                                 session->values[cell] };
+            return hint;
+        }
+    }
+    if (session->filled == 81)
+    {
+        return hint;
+    }
+
+    // Every value on the board is right, so placing them all as givens leaves the candidates the player works from
+    SudokuSolver solver;
+    unsigned short int board[9][9];
+    sudoku_solver_init(&solver);
+    sudoku_session_board(session, board);
+    const int placed = place_givens(&solver, board);
+    assert(placed && "Values of the solution conflict with each other");
+    (void)placed;
+    if (find_single(&solver, &hint))
+    {
+        return hint;
+    }
+
+    // Cheapest strategy first and back to the cheapest after every step, like `sudoku_apply_strategies`
+    SudokuTechnique hardest = SUDOKU_TECHNIQUE_NAKED_SINGLE;
+    for (;;)
+    {
+        size_t k = 0;
+        while (k < sudoku_default_strategy_count && sudoku_default_strategies[k].apply(&solver) == 0)
+        {
+            k++;
+        }
+        if (k == sudoku_default_strategy_count)
+        {
+            return hint;
+        }
+
+        const SudokuTechnique technique = sudoku_default_strategies[k].technique;
+        if (sudoku_technique_rating(technique) > sudoku_technique_rating(hardest))
+        {
+            hardest = technique;
+        }
+        if (find_single(&solver, &hint))
+        {
+            hint.technique = hardest;
+            return hint;
+        }
+    }
+}
+
+void sudoku_session_board(const SudokuSession *session, unsigned short int board[9][9]) {
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        board[cell / 9][cell % 9] = session->values[cell];
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef SUDOKU_SESSION_H
+#define SUDOKU_SESSION_H
+
+#include <stddef.h>
+#include "sudoku_solver.h"
+#include "sudoku_trace.h"
+
+/*
+ * One change made by the player, as it is kept in the undo journal: the value (or the pencil marks) the cell had
+ * before and after it
+ */
+typedef struct SudokuMove {
+    unsigned char cell;
+    unsigned char is_mark;
+    Notes before;
+    Notes after;
+} SudokuMove;
+
+/*
+ * A game in progress: the board as the player filled it, their pencil marks, and per unit counts of every value,
+ * kept up to date on every move so that checking a move or the candidates of a cell costs the same on any board.
+ * Every move goes into a journal that can be undone and redone without limit, and a new move drops the moves that
+ * were undone. Owns heap memory only for the journal, 6 bytes per move
+ */
+typedef struct SudokuSession {
+    unsigned char values[81];
+    // Solution the player's values are checked against, found once when the session starts
+    unsigned char solution[81];
+    Notes marks[81];
+    // How many times each value (index n-1) is on the board in each unit: rows are units 0-8, columns 9-17, blocks 18-26
+    unsigned char counts[27][9];
+    // Values that are on the board at least once in each unit
+    Notes used[27];
+    // Cells that are givens, one bit per cell (row after row, cell i*9+j)
+    unsigned long long givens[2];
+    unsigned short int filled;
+    // Values that are more than once in a unit, counted once per unit
+    unsigned short int conflicts;
+    SudokuMove *journal;
+    size_t journal_length;
+    // Moves before this one are on the board, the ones from here on were undone and can be redone
+    size_t journal_position;
+    size_t journal_capacity;
+} SudokuSession;
+
+typedef enum SudokuMoveStatus {
+    // The move was made
+    SUDOKU_MOVE_OK,
+    // The move was made, but the value is already in the row, column or block of the cell
+    SUDOKU_MOVE_CONFLICT,
+    // Nothing was done: the cell is a given, the value is out of range, or the cell already has it
+    SUDOKU_MOVE_REJECTED
+} SudokuMoveStatus;
+
+typedef enum SudokuHintKind {
+    // No value can be found without guessing
+    SUDOKU_HINT_NONE,
+    // The value at (row, column) is not the one of the solution, it has to go first
+    SUDOKU_HINT_MISTAKE,
+    // `value` goes at (row, column), which `technique` shows
+    SUDOKU_HINT_PLACE
+} SudokuHintKind;
+
+typedef struct SudokuHint {
+    SudokuHintKind kind;
+    // For strategies, the hardest one needed before the value could be placed by a single
+    SudokuTechnique technique;
+    unsigned short int row;
+    unsigned short int column;
+    unsigned short int value;
+} SudokuHint;
+
+/*
+ * Starts a session on `puzzle`, and solves it once to know the values the player should find
+ * Return 0 if the puzzle has no solution, >0 otherwise
+ */
+int sudoku_session_init(SudokuSession *session, unsigned short int puzzle[9][9]);
+
+void sudoku_session_destroy(SudokuSession *session);
+
+/*
+ * Puts `value` in cell (row, column), or empties it if `value` is 0
+ * Return what happened to the move, see `SudokuMoveStatus`
+ */
+SudokuMoveStatus sudoku_session_place(SudokuSession *session, unsigned short int row, unsigned short int column,
+                                      unsigned short int value);
+
+/*
+ * Adds `value` to the pencil marks of the empty cell (row, column), or takes it away if it was there
+ * Return SUDOKU_MOVE_CONFLICT if the value is already in a unit of the cell, and SUDOKU_MOVE_REJECTED if the cell
+ * is not empty or `value` is out of range
+ */
+SudokuMoveStatus sudoku_session_toggle_mark(SudokuSession *session, unsigned short int row, unsigned short int column,
+                                            unsigned short int value);
+
+/*
+ * Same checks as `sudoku_session_place`, without making the move
+ */
+SudokuMoveStatus sudoku_session_check(const SudokuSession *session, unsigned short int row, unsigned short int column,
+                                      unsigned short int value);
+
+/*
+ * Values not yet in the row, column or block of the cell
+ */
+Notes sudoku_session_candidates(const SudokuSession *session, unsigned short int row, unsigned short int column);
+
+/*
+ * Return 0 if the value at (row, column) is missing or not the one of the solution, >0 otherwise
+ */
+int sudoku_session_is_correct(const SudokuSession *session, unsigned short int row, unsigned short int column);
+
+/*
+ * Return 0 unless every cell is filled without conflicts, >0 otherwise
+ */
+int sudoku_session_is_solved(const SudokuSession *session);
+
+/*
+ * Takes back the last move, or makes again the last move taken back
+ * Return 0 if there is no such move, >0 otherwise
+ */
+int sudoku_session_undo(SudokuSession *session);
+int sudoku_session_redo(SudokuSession *session);
+
+/*
+ * Next step a human would take from the board as it is now. Mistakes come first, then the easiest single, and
+ * when there are none the strategies of `sudoku_default_strategies` are applied in order until one of them leads
+ * to a single. Only the deduction is done, starting from the candidates the board leaves, the puzzle is not solved
+ * again. The pencil marks of the player are not used
+ * Return the hint, SUDOKU_HINT_NONE if the board is solved or only guessing can move it forward
+ */
+SudokuHint sudoku_session_hint(const SudokuSession *session);
+
+/*
+ * Copies the values of the board, 0 for empty cells
+ */
+void sudoku_session_board(const SudokuSession *session, unsigned short int board[9][9]);
+
+#endif // SUDOKU_SESSION_H
@@ -0,0 +1,200 @@
+#include <stddef.h>
+#include "sudoku_simd.h"
+#include "sudoku_solver_internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_UNITS_X86 1
+#include <immintrin.h>
+#else
+#define SCAN_UNITS_X86 0
+#endif
+
+// Board index of the k-th cell of every unit (`sudoku_unit_cells` transposed), so each row of the table fills
+// one lane per unit. Padding lanes read cell 0 and are cleared at the end
+__attribute__((aligned(32)))
+static const int unit_cell_lanes[9][SCAN_UNITS] = {
+    { 0,  9, 18, 27, 36, 45, 54, 63, 72,  0,  1,  2,  3,  4,  5,  6,  7,  8,  0,  3,  6, 27, 30, 33, 54, 57, 60,  0,  0,  0,  0,  0},
+    { 1, 10, 19, 28, 37, 46, 55, 64, 73,  9, 10, 11, 12, 13, 14, 15, 16, 17,  1,  4,  7, 28, 31, 34, 55, 58, 61,  0,  0,  0,  0,  0},
+    { 2, 11, 20, 29, 38, 47, 56, 65, 74, 18, 19, 20, 21, 22, 23, 24, 25, 26,  2,  5,  8, 29, 32, 35, 56, 59, 62,  0,  0,  0,  0,  0},
+    { 3, 12, 21, 30, 39, 48, 57, 66, 75, 27, 28, 29, 30, 31, 32, 33, 34, 35,  9, 12, 15, 36, 39, 42, 63, 66, 69,  0,  0,  0,  0,  0},
+    { 4, 13, 22, 31, 40, 49, 58, 67, 76, 36, 37, 38, 39, 40, 41, 42, 43, 44, 10, 13, 16, 37, 40, 43, 64, 67, 70,  0,  0,  0,  0,  0},
+    { 5, 14, 23, 32, 41, 50, 59, 68, 77, 45, 46, 47, 48, 49, 50, 51, 52, 53, 11, 14, 17, 38, 41, 44, 65, 68, 71,  0,  0,  0,  0,  0},
+    { 6, 15, 24, 33, 42, 51, 60, 69, 78, 54, 55, 56, 57, 58, 59, 60, 61, 62, 18, 21, 24, 45, 48, 51, 72, 75, 78,  0,  0,  0,  0,  0},
+    { 7, 16, 25, 34, 43, 52, 61, 70, 79, 63, 64, 65, 66, 67, 68, 69, 70, 71, 19, 22, 25, 46, 49, 52, 73, 76, 79,  0,  0,  0,  0,  0},
+    { 8, 17, 26, 35, 44, 53, 62, 71, 80, 72, 73, 74, 75, 76, 77, 78, 79, 80, 20, 23, 26, 47, 50, 53, 74, 77, 80,  0,  0,  0,  0,  0}
+};
+
+// Candidates that count in each lane: every value for the 27 units, none for the padding
+__attribute__((aligned(32)))
+static const Notes lane_values[SCAN_UNITS] = {
+    0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF,
+    0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF,
+    0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 0x1FF,
+    0, 0, 0, 0, 0
+};
+
+static void scan_units_scalar(const SudokuSolver *solver, Notes once[SCAN_UNITS], Notes twice[SCAN_UNITS]) {
+    const Notes *board = &solver->candidates[0][0];
+
+    for (size_t u = 0; u < SCAN_UNITS; u++)
+    {
+        Notes seen_once = 0;
+        Notes seen_twice = 0;
+        for (size_t k = 0; k < 9; k++)
+        {
+            const Notes notes = board[unit_cell_lanes[k][u]];
+            seen_twice |= seen_once & notes;
+            seen_once |= notes;
+        }
+        once[u] = seen_once & lane_values[u];
+        twice[u] = seen_twice & lane_values[u];
+    }
+}
+
+#if SCAN_UNITS_X86
+/*
+ * SSE2 has no gather, so the cells are copied unit after unit into a transposed table first,
+ * and then the nine cells of 8 units are folded at a time
+ */
+__attribute__((target("sse2")))
+static void scan_units_sse2(const SudokuSolver *solver, Notes once[SCAN_UNITS], Notes twice[SCAN_UNITS]) {
+    const Notes *board = &solver->candidates[0][0];
+    __attribute__((aligned(16))) Notes lanes[9][SCAN_UNITS];
+
+    for (size_t k = 0; k < 9; k++)
+    {
+        for (size_t u = 0; u < SCAN_UNITS; u++)
+        {
+            lanes[k][u] = board[unit_cell_lanes[k][u]];
+        }
+    }
+
+    for (size_t v = 0; v < SCAN_UNITS; v += 8)
+    {
+        __m128i seen_once = _mm_load_si128((const __m128i *)&lanes[0][v]);
+        __m128i seen_twice = _mm_setzero_si128();
+        for (size_t k = 1; k < 9; k++)
+        {
+            const __m128i notes = _mm_load_si128((const __m128i *)&lanes[k][v]);
+            seen_twice = _mm_or_si128(seen_twice, _mm_and_si128(seen_once, notes));
+            seen_once = _mm_or_si128(seen_once, notes);
+        }
+        const __m128i values = _mm_load_si128((const __m128i *)&lane_values[v]);
+        _mm_storeu_si128((__m128i *)&once[v], _mm_and_si128(seen_once, values));
+        _mm_storeu_si128((__m128i *)&twice[v], _mm_and_si128(seen_twice, values));
+    }
+}
+
+/*
+ * AVX2 gathers the k-th cell of 8 units in one instruction, so the whole scan is 36 gathers and their folds
+ * Gathers read 32 bits, the low 16 are the cell. Reading cell 80 also reads the first `unit_free` after the board,
+ * which stays inside the solver, and the extra bits are cleared with the padding lanes
+ */
+__attribute__((target("avx2")))
+static void scan_units_avx2(const SudokuSolver *solver, Notes once[SCAN_UNITS], Notes twice[SCAN_UNITS]) {
+    const int *board = (const int *)(const void *)&solver->candidates[0][0];
+    __m256i seen_once[SCAN_UNITS / 8], seen_twice[SCAN_UNITS / 8];
+
+    for (size_t v = 0; v < SCAN_UNITS / 8; v++)
+    {
+        const __m256i cells = _mm256_load_si256((const __m256i *)&unit_cell_lanes[0][v * 8]);
+        seen_once[v] = _mm256_i32gather_epi32(board, cells, 2);
+        seen_twice[v] = _mm256_setzero_si256();
+    }
+    for (size_t k = 1; k < 9; k++)
+    {
+        for (size_t v = 0; v < SCAN_UNITS / 8; v++)
+        {
+            const __m256i cells = _mm256_load_si256((const __m256i *)&unit_cell_lanes[k][v * 8]);
+            const __m256i notes = _mm256_i32gather_epi32(board, cells, 2);
+            seen_twice[v] = _mm256_or_si256(seen_twice[v], _mm256_and_si256(seen_once[v], notes));
+            seen_once[v] = _mm256_or_si256(seen_once[v], notes);
+        }
+    }
+
+    // Units 27-31 are padding, and every lane carries the 16 bits after its cell, which are cleared with them
+    const __m256i values = _mm256_set1_epi32(NOTES_ALL_VALUES);
+    const __m256i last_values = _mm256_setr_epi32(NOTES_ALL_VALUES, NOTES_ALL_VALUES, NOTES_ALL_VALUES, 0, 0, 0, 0, 0);
+    for (size_t v = 0; v < SCAN_UNITS / 8; v++)
+    {
+        seen_once[v] = _mm256_and_si256(seen_once[v], v + 1 < SCAN_UNITS / 8 ? values : last_values);
+        seen_twice[v] = _mm256_and_si256(seen_twice[v], v + 1 < SCAN_UNITS / 8 ? values : last_values);
+    }
+
+    // Packing 32 bit lanes to 16 bits interleaves the 128 bit halves, the permutation puts the units back in order
+    for (size_t v = 0; v < SCAN_UNITS / 8; v += 2)
+    {
+        const __m256i packed_once = _mm256_packus_epi32(seen_once[v], seen_once[v + 1]);
+        const __m256i packed_twice = _mm256_packus_epi32(seen_twice[v], seen_twice[v + 1]);
+        _mm256_storeu_si256((__m256i *)&once[v * 8], _mm256_permute4x64_epi64(packed_once, 0xD8));
+        _mm256_storeu_si256((__m256i *)&twice[v * 8], _mm256_permute4x64_epi64(packed_twice, 0xD8));
+    }
+}
+#endif
+
+/*
+ * Best version for this CPU, looked up once. Every thread that gets here first finds the same answer,
+ * so the atomics are only there to make the race harmless
+ */
+static ScanUnitsFunction resolved_scan_units = NULL;
+static const char *resolved_version = NULL;
+
+static ScanUnitsFunction resolve_scan_units() {
+    ScanUnitsFunction scan = __atomic_load_n(&resolved_scan_units, __ATOMIC_ACQUIRE);
+    if (scan != NULL)
+    {
+        return scan;
+    }
+
+    const char *version = "scalar";
+    scan = scan_units_scalar;
+#if SCAN_UNITS_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        version = "avx2";
+        scan = scan_units_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        version = "sse2";
+        scan = scan_units_sse2;
+    }
+#endif
+    __atomic_store_n(&resolved_version, version, __ATOMIC_RELAXED);
+    __atomic_store_n(&resolved_scan_units, scan, __ATOMIC_RELEASE);
+    return scan;
+}
+
+// -- PUBLIC -- //
+void scan_units(const SudokuSolver *solver, Notes once[SCAN_UNITS], Notes twice[SCAN_UNITS]) {
+    resolve_scan_units()(solver, once, twice);
+}
+
+const char *scan_units_version() {
+    resolve_scan_units();
+    return __atomic_load_n(&resolved_version, __ATOMIC_RELAXED);
+}
+
+ScanUnitsFunction scan_units_scalar_version() {
+    return scan_units_scalar;
+}
+
+ScanUnitsFunction scan_units_sse2_version() {
+#if SCAN_UNITS_X86
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return scan_units_sse2;
+    }
+#endif
+    return NULL;
+}
+
+ScanUnitsFunction scan_units_avx2_version() {
+#if SCAN_UNITS_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return scan_units_avx2;
+    }
+#endif
+    return NULL;
+}
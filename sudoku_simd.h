@@ -0,0 +1,31 @@
+#ifndef SUDOKU_SIMD_H
+#define SUDOKU_SIMD_H
+
+/*
+ * Vectorised scan of the candidates of all 27 units at once, for the hidden singles
+ * Not part of the public API. The widest version the CPU supports is picked the first time it is used
+ */
+
+#include "sudoku_solver.h"
+
+// Units padded to a whole number of vectors, the padding lanes are left at 0
+#define SCAN_UNITS 32
+
+/*
+ * For every unit (rows 0-8, columns 9-17, blocks 18-26): `once[u]` gets the values that are a candidate of at least
+ * one of its cells, and `twice[u]` the values that are a candidate of at least two, so `once & ~twice` are the
+ * values left with a single cell in the unit
+ */
+typedef void (*ScanUnitsFunction)(const SudokuSolver *solver, Notes once[SCAN_UNITS], Notes twice[SCAN_UNITS]);
+
+void scan_units(const SudokuSolver *solver, Notes once[SCAN_UNITS], Notes twice[SCAN_UNITS]);
+
+// Name of the version `scan_units` uses on this CPU: "avx2", "sse2" or "scalar"
+const char *scan_units_version();
+
+// Every version built in, for benchmarks and for comparing them. NULL for the ones this CPU cannot run
+ScanUnitsFunction scan_units_scalar_version();
+ScanUnitsFunction scan_units_sse2_version();
+ScanUnitsFunction scan_units_avx2_version();
+
+#endif // SUDOKU_SIMD_H
@@ -1,235 +1,506 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stddef.h>
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
+#include <time.h>
 #include "sudoku_solver.h"
+#include "sudoku_solver_internal.h"
+#include "sudoku_strategies.h"
+#include "sudoku_simd.h"
 
-#define SUDOKU_MAX_ITERATIONS 10
+// With at least this many dirty units, all 27 are scanned at once instead of one after the other
+#ifndef SCAN_ALL_UNITS_FROM
+#define SCAN_ALL_UNITS_FROM 12
+#endif
 
-/*
- * Notes for a single cell
- * A cell starts by having 9 possible values (1-9), until only 1 is left, which becomes the number of the cell
- * If `values[n]` is 0 then n+1 is not a possible value in this cell. Otherwise `values[n]` is equal to n+1
- */
-typedef struct Notes {
-    unsigned short int values[9];
-} Notes;
+// Board index (i*9+j) of the cells of each unit: rows are units 0-8, columns 9-17 and blocks 18-26
+const unsigned char sudoku_unit_cells[27][9] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8},
+    { 9, 10, 11, 12, 13, 14, 15, 16, 17},
+    {18, 19, 20, 21, 22, 23, 24, 25, 26},
+    {27, 28, 29, 30, 31, 32, 33, 34, 35},
+    {36, 37, 38, 39, 40, 41, 42, 43, 44},
+    {45, 46, 47, 48, 49, 50, 51, 52, 53},
+    {54, 55, 56, 57, 58, 59, 60, 61, 62},
+    {63, 64, 65, 66, 67, 68, 69, 70, 71},
+    {72, 73, 74, 75, 76, 77, 78, 79, 80},
+    { 0,  9, 18, 27, 36, 45, 54, 63, 72},
+    { 1, 10, 19, 28, 37, 46, 55, 64, 73},
+    { 2, 11, 20, 29, 38, 47, 56, 65, 74},
+    { 3, 12, 21, 30, 39, 48, 57, 66, 75},
+    { 4, 13, 22, 31, 40, 49, 58, 67, 76},
+    { 5, 14, 23, 32, 41, 50, 59, 68, 77},
+    { 6, 15, 24, 33, 42, 51, 60, 69, 78},
+    { 7, 16, 25, 34, 43, 52, 61, 70, 79},
+    { 8, 17, 26, 35, 44, 53, 62, 71, 80},
+    { 0,  1,  2,  9, 10, 11, 18, 19, 20},
+    { 3,  4,  5, 12, 13, 14, 21, 22, 23},
+    { 6,  7,  8, 15, 16, 17, 24, 25, 26},
+    {27, 28, 29, 36, 37, 38, 45, 46, 47},
+    {30, 31, 32, 39, 40, 41, 48, 49, 50},
+    {33, 34, 35, 42, 43, 44, 51, 52, 53},
+    {54, 55, 56, 63, 64, 65, 72, 73, 74},
+    {57, 58, 59, 66, 67, 68, 75, 76, 77},
+    {60, 61, 62, 69, 70, 71, 78, 79, 80}
+};
+
+// Bits of `dirty_units` for the row, column and block of each cell
+const unsigned int sudoku_cell_units[81] = {
+    0x0040201, 0x0040401, 0x0040801, 0x0081001, 0x0082001, 0x0084001, 0x0108001, 0x0110001, 0x0120001,
+    0x0040202, 0x0040402, 0x0040802, 0x0081002, 0x0082002, 0x0084002, 0x0108002, 0x0110002, 0x0120002,
+    0x0040204, 0x0040404, 0x0040804, 0x0081004, 0x0082004, 0x0084004, 0x0108004, 0x0110004, 0x0120004,
+    0x0200208, 0x0200408, 0x0200808, 0x0401008, 0x0402008, 0x0404008, 0x0808008, 0x0810008, 0x0820008,
+    0x0200210, 0x0200410, 0x0200810, 0x0401010, 0x0402010, 0x0404010, 0x0808010, 0x0810010, 0x0820010,
+    0x0200220, 0x0200420, 0x0200820, 0x0401020, 0x0402020, 0x0404020, 0x0808020, 0x0810020, 0x0820020,
+    0x1000240, 0x1000440, 0x1000840, 0x2001040, 0x2002040, 0x2004040, 0x4008040, 0x4010040, 0x4020040,
+    0x1000280, 0x1000480, 0x1000880, 0x2001080, 0x2002080, 0x2004080, 0x4008080, 0x4010080, 0x4020080,
+    0x1000300, 0x1000500, 0x1000900, 0x2001100, 0x2002100, 0x2004100, 0x4008100, 0x4010100, 0x4020100
+};
 
-// All candidates for all cells of the board (9x9 board), by using one `Notes` per cell of the board
-Notes candidates[9][9];
+// Board index of the 20 cells that share a row, column or block with each cell
+const unsigned char sudoku_cell_peers[81][20] = {
+    { 1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 18, 19, 20, 27, 36, 45, 54, 63, 72},
+    { 0,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 18, 19, 20, 28, 37, 46, 55, 64, 73},
+    { 0,  1,  3,  4,  5,  6,  7,  8,  9, 10, 11, 18, 19, 20, 29, 38, 47, 56, 65, 74},
+    { 0,  1,  2,  4,  5,  6,  7,  8, 12, 13, 14, 21, 22, 23, 30, 39, 48, 57, 66, 75},
+    { 0,  1,  2,  3,  5,  6,  7,  8, 12, 13, 14, 21, 22, 23, 31, 40, 49, 58, 67, 76},
+    { 0,  1,  2,  3,  4,  6,  7,  8, 12, 13, 14, 21, 22, 23, 32, 41, 50, 59, 68, 77},
+    { 0,  1,  2,  3,  4,  5,  7,  8, 15, 16, 17, 24, 25, 26, 33, 42, 51, 60, 69, 78},
+    { 0,  1,  2,  3,  4,  5,  6,  8, 15, 16, 17, 24, 25, 26, 34, 43, 52, 61, 70, 79},
+    { 0,  1,  2,  3,  4,  5,  6,  7, 15, 16, 17, 24, 25, 26, 35, 44, 53, 62, 71, 80},
+    { 0,  1,  2, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 27, 36, 45, 54, 63, 72},
+    { 0,  1,  2,  9, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 28, 37, 46, 55, 64, 73},
+    { 0,  1,  2,  9, 10, 12, 13, 14, 15, 16, 17, 18, 19, 20, 29, 38, 47, 56, 65, 74},
+    { 3,  4,  5,  9, 10, 11, 13, 14, 15, 16, 17, 21, 22, 23, 30, 39, 48, 57, 66, 75},
+    { 3,  4,  5,  9, 10, 11, 12, 14, 15, 16, 17, 21, 22, 23, 31, 40, 49, 58, 67, 76},
+    { 3,  4,  5,  9, 10, 11, 12, 13, 15, 16, 17, 21, 22, 23, 32, 41, 50, 59, 68, 77},
+    { 6,  7,  8,  9, 10, 11, 12, 13, 14, 16, 17, 24, 25, 26, 33, 42, 51, 60, 69, 78},
+    { 6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 17, 24, 25, 26, 34, 43, 52, 61, 70, 79},
+    { 6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 24, 25, 26, 35, 44, 53, 62, 71, 80},
+    { 0,  1,  2,  9, 10, 11, 19, 20, 21, 22, 23, 24, 25, 26, 27, 36, 45, 54, 63, 72},
+    { 0,  1,  2,  9, 10, 11, 18, 20, 21, 22, 23, 24, 25, 26, 28, 37, 46, 55, 64, 73},
+    { 0,  1,  2,  9, 10, 11, 18, 19, 21, 22, 23, 24, 25, 26, 29, 38, 47, 56, 65, 74},
+    { 3,  4,  5, 12, 13, 14, 18, 19, 20, 22, 23, 24, 25, 26, 30, 39, 48, 57, 66, 75},
+    { 3,  4,  5, 12, 13, 14, 18, 19, 20, 21, 23, 24, 25, 26, 31, 40, 49, 58, 67, 76},
+    { 3,  4,  5, 12, 13, 14, 18, 19, 20, 21, 22, 24, 25, 26, 32, 41, 50, 59, 68, 77},
+    { 6,  7,  8, 15, 16, 17, 18, 19, 20, 21, 22, 23, 25, 26, 33, 42, 51, 60, 69, 78},
+    { 6,  7,  8, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 26, 34, 43, 52, 61, 70, 79},
+    { 6,  7,  8, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 35, 44, 53, 62, 71, 80},
+    { 0,  9, 18, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 45, 46, 47, 54, 63, 72},
+    { 1, 10, 19, 27, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 45, 46, 47, 55, 64, 73},
+    { 2, 11, 20, 27, 28, 30, 31, 32, 33, 34, 35, 36, 37, 38, 45, 46, 47, 56, 65, 74},
+    { 3, 12, 21, 27, 28, 29, 31, 32, 33, 34, 35, 39, 40, 41, 48, 49, 50, 57, 66, 75},
+    { 4, 13, 22, 27, 28, 29, 30, 32, 33, 34, 35, 39, 40, 41, 48, 49, 50, 58, 67, 76},
+    { 5, 14, 23, 27, 28, 29, 30, 31, 33, 34, 35, 39, 40, 41, 48, 49, 50, 59, 68, 77},
+    { 6, 15, 24, 27, 28, 29, 30, 31, 32, 34, 35, 42, 43, 44, 51, 52, 53, 60, 69, 78},
+    { 7, 16, 25, 27, 28, 29, 30, 31, 32, 33, 35, 42, 43, 44, 51, 52, 53, 61, 70, 79},
+    { 8, 17, 26, 27, 28, 29, 30, 31, 32, 33, 34, 42, 43, 44, 51, 52, 53, 62, 71, 80},
+    { 0,  9, 18, 27, 28, 29, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 54, 63, 72},
+    { 1, 10, 19, 27, 28, 29, 36, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 55, 64, 73},
+    { 2, 11, 20, 27, 28, 29, 36, 37, 39, 40, 41, 42, 43, 44, 45, 46, 47, 56, 65, 74},
+    { 3, 12, 21, 30, 31, 32, 36, 37, 38, 40, 41, 42, 43, 44, 48, 49, 50, 57, 66, 75},
+    { 4, 13, 22, 30, 31, 32, 36, 37, 38, 39, 41, 42, 43, 44, 48, 49, 50, 58, 67, 76},
+    { 5, 14, 23, 30, 31, 32, 36, 37, 38, 39, 40, 42, 43, 44, 48, 49, 50, 59, 68, 77},
+    { 6, 15, 24, 33, 34, 35, 36, 37, 38, 39, 40, 41, 43, 44, 51, 52, 53, 60, 69, 78},
+    { 7, 16, 25, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 44, 51, 52, 53, 61, 70, 79},
+    { 8, 17, 26, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 51, 52, 53, 62, 71, 80},
+    { 0,  9, 18, 27, 28, 29, 36, 37, 38, 46, 47, 48, 49, 50, 51, 52, 53, 54, 63, 72},
+    { 1, 10, 19, 27, 28, 29, 36, 37, 38, 45, 47, 48, 49, 50, 51, 52, 53, 55, 64, 73},
+    { 2, 11, 20, 27, 28, 29, 36, 37, 38, 45, 46, 48, 49, 50, 51, 52, 53, 56, 65, 74},
+    { 3, 12, 21, 30, 31, 32, 39, 40, 41, 45, 46, 47, 49, 50, 51, 52, 53, 57, 66, 75},
+    { 4, 13, 22, 30, 31, 32, 39, 40, 41, 45, 46, 47, 48, 50, 51, 52, 53, 58, 67, 76},
+    { 5, 14, 23, 30, 31, 32, 39, 40, 41, 45, 46, 47, 48, 49, 51, 52, 53, 59, 68, 77},
+    { 6, 15, 24, 33, 34, 35, 42, 43, 44, 45, 46, 47, 48, 49, 50, 52, 53, 60, 69, 78},
+    { 7, 16, 25, 33, 34, 35, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 53, 61, 70, 79},
+    { 8, 17, 26, 33, 34, 35, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 62, 71, 80},
+    { 0,  9, 18, 27, 36, 45, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 72, 73, 74},
+    { 1, 10, 19, 28, 37, 46, 54, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 72, 73, 74},
+    { 2, 11, 20, 29, 38, 47, 54, 55, 57, 58, 59, 60, 61, 62, 63, 64, 65, 72, 73, 74},
+    { 3, 12, 21, 30, 39, 48, 54, 55, 56, 58, 59, 60, 61, 62, 66, 67, 68, 75, 76, 77},
+    { 4, 13, 22, 31, 40, 49, 54, 55, 56, 57, 59, 60, 61, 62, 66, 67, 68, 75, 76, 77},
+    { 5, 14, 23, 32, 41, 50, 54, 55, 56, 57, 58, 60, 61, 62, 66, 67, 68, 75, 76, 77},
+    { 6, 15, 24, 33, 42, 51, 54, 55, 56, 57, 58, 59, 61, 62, 69, 70, 71, 78, 79, 80},
+    { 7, 16, 25, 34, 43, 52, 54, 55, 56, 57, 58, 59, 60, 62, 69, 70, 71, 78, 79, 80},
+    { 8, 17, 26, 35, 44, 53, 54, 55, 56, 57, 58, 59, 60, 61, 69, 70, 71, 78, 79, 80},
+    { 0,  9, 18, 27, 36, 45, 54, 55, 56, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74},
+    { 1, 10, 19, 28, 37, 46, 54, 55, 56, 63, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74},
+    { 2, 11, 20, 29, 38, 47, 54, 55, 56, 63, 64, 66, 67, 68, 69, 70, 71, 72, 73, 74},
+    { 3, 12, 21, 30, 39, 48, 57, 58, 59, 63, 64, 65, 67, 68, 69, 70, 71, 75, 76, 77},
+    { 4, 13, 22, 31, 40, 49, 57, 58, 59, 63, 64, 65, 66, 68, 69, 70, 71, 75, 76, 77},
+    { 5, 14, 23, 32, 41, 50, 57, 58, 59, 63, 64, 65, 66, 67, 69, 70, 71, 75, 76, 77},
+    { 6, 15, 24, 33, 42, 51, 60, 61, 62, 63, 64, 65, 66, 67, 68, 70, 71, 78, 79, 80},
+    { 7, 16, 25, 34, 43, 52, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 71, 78, 79, 80},
+    { 8, 17, 26, 35, 44, 53, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 78, 79, 80},
+    { 0,  9, 18, 27, 36, 45, 54, 55, 56, 63, 64, 65, 73, 74, 75, 76, 77, 78, 79, 80},
+    { 1, 10, 19, 28, 37, 46, 54, 55, 56, 63, 64, 65, 72, 74, 75, 76, 77, 78, 79, 80},
+    { 2, 11, 20, 29, 38, 47, 54, 55, 56, 63, 64, 65, 72, 73, 75, 76, 77, 78, 79, 80},
+    { 3, 12, 21, 30, 39, 48, 57, 58, 59, 66, 67, 68, 72, 73, 74, 76, 77, 78, 79, 80},
+    { 4, 13, 22, 31, 40, 49, 57, 58, 59, 66, 67, 68, 72, 73, 74, 75, 77, 78, 79, 80},
+    { 5, 14, 23, 32, 41, 50, 57, 58, 59, 66, 67, 68, 72, 73, 74, 75, 76, 78, 79, 80},
+    { 6, 15, 24, 33, 42, 51, 60, 61, 62, 69, 70, 71, 72, 73, 74, 75, 76, 77, 79, 80},
+    { 7, 16, 25, 34, 43, 52, 60, 61, 62, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 80},
+    { 8, 17, 26, 35, 44, 53, 60, 61, 62, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79}
+};
 
-void init_candidates() {
+static void init_candidates(SudokuSolver *solver) {
     for (size_t i = 0; i < 9; i++)
     {
         for (size_t j = 0; j < 9; j++)
         {
-            for (size_t k = 0; k < 9; k++)
-            {
-                candidates[i][j].values[k] = k + 1;
-            }
+            solver->candidates[i][j] = NOTES_ALL_VALUES;
         }
     }
+    for (size_t unit = 0; unit < 27; unit++)
+    {
+        solver->unit_free[unit] = NOTES_ALL_VALUES;
+    }
+    solver->unsolved[0] = ~0ull;
+    solver->unsolved[1] = (1ull << (81 - 64)) - 1;
+    solver->pending[0] = 0;
+    solver->pending[1] = 0;
+    solver->dirty_units = 0;
+    solver->trace = NULL;
 }
 
-void set_candidate_single_value(unsigned short int n, unsigned short int i, unsigned short int j) {
-    for (unsigned short int n_ = 0; n_ < 9; n_++)
+static void set_candidate_single_value(SudokuSolver *solver, unsigned short int n, unsigned short int i, unsigned short int j) {
+    assert((solver->candidates[i][j] & NOTES_BIT(n)) != 0 && "Cell should have value, not 0");
+    if (solver->candidates[i][j] != NOTES_BIT(n))
     {
-        if (n_ == n-1)
-        {
-            assert(candidates[i][j].values[n_] != 0 && "Cell should have value, not 0");
-            assert(candidates[i][j].values[n_] == n && "Cell has wrong value in index");
-            continue;
-        }
-        candidates[i][j].values[n_] = 0;
+        // The other candidates of this cell are gone, which can leave a hidden single in any of its units
+        solver->candidates[i][j] = NOTES_BIT(n);
+        solver->dirty_units |= sudoku_cell_units[i * 9 + j];
     }
 }
 
-void clear_number_from_block(unsigned short int n, unsigned short int i, unsigned short int j) {
-    unsigned short int i_start, i_end, j_start, j_end;
-    i_start = (i / 3) * 3;
-    i_end = i_start + 2;
-    j_start = (j / 3) * 3;
-    j_end = j_start + 2;
-    
-    assert((i_start == 0 || i_start == 3 || i_start == 6) && "Calculation for indices in block are wrong");
-    assert((j_start == 0 || j_start == 3 || j_start == 6) && "Calculation for indices in block are wrong");
-    assert((i_end == 2 || i_end == 5 || i_end == 8) && "Calculation for indices in block are wrong");
-    assert((j_end == 2 || j_end == 5 || j_end == 8) && "Calculation for indices in block are wrong");
-
-    for (size_t i_ = i_start; i_ <= i_end; i_++)
+void handle_number_in_cell(SudokuSolver *solver, unsigned short int n, unsigned short int i, unsigned short int j) {
+    assert(n != 0 && "Must not set number in cell to 0");
+    assert(is_cell_unsolved(solver, i * 9 + j) && "Cell already has a number");
+
+    const unsigned short int cell = i * 9 + j;
+    solver->unsolved[cell / 64] &= ~(1ull << (cell % 64));
+
+    set_candidate_single_value(solver, n, i, j);
+    for (unsigned short int k = 0; k < 20; k++)
     {
-        for (size_t j_ = j_start; j_ <= j_end; j_++)
-        {
-            if (i == i_ && j == j_)
-            {
-                assert(candidates[i][j].values[n-1] != 0 && "Cell should have value, not 0");
-                assert(candidates[i][j].values[n-1] == n && "Cell has wrong value in index");
-                continue;
-            }
-            candidates[i_][j_].values[n-1] = 0;
-        }
+        remove_candidate(solver, n, sudoku_cell_peers[cell][k]);
+    }
+    for (unsigned int units = sudoku_cell_units[cell]; units != 0; units &= units - 1)
+    {
+        solver->unit_free[__builtin_ctz(units)] &= (Notes)~NOTES_BIT(n);
     }
 }
 
-void clear_number_from_column(unsigned short int n, unsigned short int i, unsigned short int j) {
-    for (size_t i_ = 0; i_ < 9; i_ ++)
+static int only_one_candidate_in_cell(const SudokuSolver *solver, unsigned short int i, unsigned short int j) {
+    const Notes notes = solver->candidates[i][j];
+    if (notes == 0 || (notes & (notes - 1)) != 0)
     {
-        if (i_ == i)
-        {
-            assert(candidates[i][j].values[n-1] != 0 && "Cell should have value, not 0");
-            assert(candidates[i][j].values[n-1] == n && "Cell has wrong value in index");
-            continue;
-        }
-        candidates[i_][j].values[n-1] = 0;
+        return 0;
     }
+    return __builtin_ctz(notes) + 1;
 }
 
-void clear_number_from_row(unsigned short int n, unsigned short int i, unsigned short int j) {
-    for (size_t j_ = 0; j_ < 9; j_ ++)
+/*
+ * Places every value that fits in only one cell of `unit`, given the values seen in at least one (`seen_once`)
+ * and in at least two (`seen_twice`) of its cells. These may be older than the board: candidates are only ever
+ * removed, so a value seen once can only have kept its cell or lost it, and losing it marks the unit dirty again
+ * Return 0 if a value that still has to be placed in the unit has no cell left there, >0 otherwise
+ */
+static int place_hidden_singles(SudokuSolver *solver, unsigned short int unit, Notes seen_once, Notes seen_twice) {
+    const unsigned char *cells = sudoku_unit_cells[unit];
+    const Notes *board = &solver->candidates[0][0];
+
+    const Notes free_values = unit_free_values(solver, unit);
+    if ((free_values & (Notes)~seen_once) != 0)
     {
-        if (j_ == j)
+        return 0;
+    }
+
+    for (Notes singles = seen_once & (Notes)~seen_twice & free_values; singles != 0; singles &= singles - 1)
+    {
+        const unsigned short int n = __builtin_ctz(singles) + 1;
+        for (unsigned short int k = 0; k < 9; k++)
         {
-            assert(candidates[i][j].values[n-1] != 0 && "Cell should have value, not 0");
-            assert(candidates[i][j].values[n-1] == n && "Cell has wrong value in index");
-            continue;
+            if ((board[cells[k]] & NOTES_BIT(n)) != 0)
+            {
+                // Another hidden single of this unit may have taken the cell already, the queue will catch that
+                if (is_cell_unsolved(solver, cells[k]))
+                {
+                    // Units are numbered rows, columns, blocks, in the same order as the hidden single techniques
+                    TRACE_ADD(solver, uses[SUDOKU_TECHNIQUE_HIDDEN_SINGLE_ROW + unit / 9], 1);
+                    handle_number_in_cell(solver, n, cells[k] / 9, cells[k] % 9);
+                }
+                break;
+            }
         }
-        candidates[i][j_].values[n-1] = 0;
     }
+    return 1;
 }
 
-void handle_number_in_cell(unsigned short int n, unsigned short int i, unsigned short int j) {
-    assert(n != 0 && "Must not set number in cell to 0");
-    clear_number_from_row(n, i, j);
-    clear_number_from_column(n, i, j);
-    clear_number_from_block(n, i, j);
-    set_candidate_single_value(n, i, j);
+/*
+ * Places every value that fits in only one cell of `unit`
+ * `seen_twice` collects every value already seen before, so whatever is left in `seen_once` appeared a single time
+ * Return 0 if a value that still has to be placed in the unit has no cell left there, >0 otherwise
+ */
+static int check_hidden_singles(SudokuSolver *solver, unsigned short int unit) {
+    const unsigned char *cells = sudoku_unit_cells[unit];
+    const Notes *board = &solver->candidates[0][0];
+    Notes seen_once = 0;
+    Notes seen_twice = 0;
+
+    for (unsigned short int k = 0; k < 9; k++)
+    {
+        const Notes notes = board[cells[k]];
+        seen_twice |= seen_once & notes;
+        seen_once |= notes;
+    }
+    return place_hidden_singles(solver, unit, seen_once, seen_twice);
 }
 
-int only_one_candidate_in_cell(unsigned short int i, unsigned short int j) {
-    unsigned short int candidate = 0;
-    for (size_t n_ = 0; n_ < 9; n_++)
+/*
+ * Same as `check_hidden_singles` for every dirty unit, with the candidates of all 27 units scanned in one go by
+ * the vectorised kernel. It is cheaper than one unit at a time once enough units are dirty
+ * Return 0 if the board reached a contradiction, >0 otherwise
+ */
+static int check_all_hidden_singles(SudokuSolver *solver) {
+    Notes seen_once[SCAN_UNITS], seen_twice[SCAN_UNITS];
+    const unsigned int units = solver->dirty_units;
+    solver->dirty_units = 0;
+    scan_units(solver, seen_once, seen_twice);
+
+    for (unsigned int bits = units; bits != 0; bits &= bits - 1)
     {
-        if (candidate == 0)
-        {
-            candidate = candidates[i][j].values[n_];
-        }
-        else if (candidates[i][j].values[n_] != 0)
+        const unsigned short int unit = __builtin_ctz(bits);
+        TRACE_DETAIL_ADD(solver, propagation_steps, 1);
+        if (!place_hidden_singles(solver, unit, seen_once[unit], seen_twice[unit]))
         {
             return 0;
         }
     }
-    return candidate;
+    return 1;
+}
+
+// Number of bits set, without the libgcc call `__builtin_popcount` becomes when the CPU has no popcnt
+static inline unsigned int count_units(unsigned int units) {
+    units = units - ((units >> 1) & 0x55555555u);
+    units = (units & 0x33333333u) + ((units >> 2) & 0x33333333u);
+    return (((units + (units >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
 }
 
-void check_hidden_singles() {
-    // First check for each value in each row:
-    for (unsigned short n = 1; n <= 9; n++)
+/*
+ * Runs naked and hidden singles until nothing is left to look at
+ * Only cells that lost candidates (`pending`) and units that lost candidates (`dirty_units`) are checked,
+ * and every placement queues only the cells and units it touched, so the work follows the changes on the board
+ * Return 0 if the board reached a contradiction, >0 otherwise
+ */
+int propagate_singles(SudokuSolver *solver) {
+    for (;;)
     {
-        for (unsigned short i = 0; i < 9; i++)
+        const size_t word = solver->pending[0] != 0 ? 0 : 1;
+        if (solver->pending[word] != 0)
         {
-            unsigned short row_n_count = 0;
-            short row_index = -1;
+            const unsigned short int cell = word * 64 + __builtin_ctzll(solver->pending[word]);
+            solver->pending[word] &= solver->pending[word] - 1;
+            TRACE_DETAIL_ADD(solver, propagation_steps, 1);
 
-            for (unsigned short j = 0; j < 9; j++)
+            const unsigned short int i = cell / 9, j = cell % 9;
+            if (solver->candidates[i][j] == 0)
             {
-                if (candidates[i][j].values[n-1] != 0)
-                {
-                    row_n_count++;
-                    row_index = j;
-                }
+                return 0;
             }
-            
-            if (row_n_count == 1)
+            if (is_cell_unsolved(solver, cell))
             {
-                assert(row_index >= 0 && row_index < 9 && "Row index not in valid range");
-                handle_number_in_cell(n, i, row_index);
+                TRACE_ADD(solver, uses[SUDOKU_TECHNIQUE_NAKED_SINGLE], 1);
+                handle_number_in_cell(solver, only_one_candidate_in_cell(solver, i, j), i, j);
             }
+            continue;
         }
-    }
-    // Then check for each value in each column
-    for (unsigned short n = 1; n <= 9; n++)
-    {
-        for (unsigned short j = 0; j < 9; j++)
-        {
-            unsigned short column_n_count = 0;
-            short column_index = -1;
 
-            for (unsigned short i = 0; i < 9; i++)
+        if (count_units(solver->dirty_units) >= SCAN_ALL_UNITS_FROM)
+        {
+            if (!check_all_hidden_singles(solver))
             {
-                if (candidates[i][j].values[n-1] != 0)
-                {
-                    column_n_count++;
-                    column_index = i;
-                }
+                return 0;
             }
-            
-            if (column_n_count == 1)
+            continue;
+        }
+
+        if (solver->dirty_units != 0)
+        {
+            const unsigned short int unit = __builtin_ctz(solver->dirty_units);
+            solver->dirty_units &= solver->dirty_units - 1;
+            TRACE_DETAIL_ADD(solver, propagation_steps, 1);
+            if (!check_hidden_singles(solver, unit))
             {
-                assert(column_index >= 0 && column_index < 9 && "Column index not in valid range");
-                handle_number_in_cell(n, column_index, j);
+                return 0;
             }
+            continue;
         }
+
+        return 1;
     }
-    // Lastly check for each value in each block
-    for (unsigned short n = 1; n <= 9; n++)
+}
+
+unsigned short int pick_search_cell(const SudokuSolver *solver) {
+    unsigned short int best_cell = 81;
+    int best_count = 10;
+
+    for (size_t word = 0; word < 2; word++)
     {
-        for (unsigned short box_center_i = 1; box_center_i < 9; box_center_i+=3)
+        for (unsigned long long bits = solver->unsolved[word]; bits != 0; bits &= bits - 1)
         {
-            for (unsigned short box_center_j = 1; box_center_j < 9; box_center_j+=3)
+            const unsigned short int cell = word * 64 + __builtin_ctzll(bits);
+            const int count = __builtin_popcount(solver->candidates[cell / 9][cell % 9]);
+            if (count < best_count)
             {
-                unsigned short block_n_count = 0;
-                short n_index_i = -1;
-                short n_index_j = -1;
-
-                unsigned short int i_start, i_end, j_start, j_end;
-                i_start = (box_center_i / 3) * 3;
-                i_end = i_start + 2;
-                j_start = (box_center_j / 3) * 3;
-                j_end = j_start + 2;
-
-                // Iterating the 9 cells in this block
-                for (unsigned short i_ = i_start; i_ <= i_end; i_++)
+                best_cell = cell;
+                best_count = count;
+                if (count <= 2)
                 {
-                    for (unsigned short j_ = j_start; j_ <= j_end; j_++)
-                    {
-                        if (candidates[i_][j_].values[n-1] != 0)
-                        {
-                            block_n_count++;
-                            n_index_i = i_;
-                            n_index_j = j_;
-                        }
-                    }
-                }
-                if (block_n_count == 1) {
-                    assert(n_index_i >= 0 && n_index_i < 9 && "Column index not in valid range");
-                    assert(n_index_j >= 0 && n_index_j < 9 && "Column index not in valid range");
-                    handle_number_in_cell(n, n_index_i, n_index_j);
+                    return best_cell;
                 }
             }
         }
     }
+    return best_cell;
 }
 
 /*
- * Return 0 if is not fully solved, >0 otherwise.
+ * Depth first search for a solution, running the singles as propagation at every node
+ * Every guess works on a copy of the solver (a few cache lines), so backtracking is just dropping the copy.
+ * Guesses and dead ends are counted in `trace` (if not NULL), apart from the trace of the solver itself
+ * Return 0 if there is no solution from this state, >0 otherwise with the solution left in `solver`
  */
-int is_not_fully_solved(unsigned short int final_board[9][9]) {
+static int search(SudokuSolver *solver, SudokuTrace *trace) {
+    if (!propagate_singles(solver))
+    {
+        return 0;
+    }
+
+    const unsigned short int cell = pick_search_cell(solver);
+    if (cell == 81)
+    {
+        return 1;
+    }
+
+    const unsigned short int i = cell / 9, j = cell % 9;
+    for (Notes options = solver->candidates[i][j]; options != 0; options &= options - 1)
+    {
+        SudokuSolver guess = *solver;
+        TRACE_ADD_TO(trace, guesses, 1);
+        handle_number_in_cell(&guess, __builtin_ctz(options) + 1, i, j);
+        if (search(&guess, trace))
+        {
+            *solver = guess;
+            return 1;
+        }
+        TRACE_ADD_TO(trace, dead_ends, 1);
+    }
+    return 0;
+}
+
+unsigned int count_solutions(SudokuSolver *solver, unsigned int limit) {
+    if (!propagate_singles(solver))
+    {
+        return 0;
+    }
+
+    const unsigned short int cell = pick_search_cell(solver);
+    if (cell == 81)
+    {
+        return 1;
+    }
+
+    const unsigned short int i = cell / 9, j = cell % 9;
+    unsigned int found = 0;
+    for (Notes options = solver->candidates[i][j]; options != 0 && found < limit; options &= options - 1)
+    {
+        SudokuSolver guess = *solver;
+        handle_number_in_cell(&guess, __builtin_ctz(options) + 1, i, j);
+        found += count_solutions(&guess, limit - found);
+    }
+    return found;
+}
+
+int place_givens(SudokuSolver *solver, unsigned short int input[9][9]) {
     for (size_t i = 0; i < 9; i++)
     {
         for (size_t j = 0; j < 9; j++)
         {
-            if (final_board[i][j] == 0) {
-                return 0;
+            unsigned short int n = input[i][j];
+            if (n >= 1 && n <= 9)
+            {
+                // A given that was already removed from this cell repeats another given in its row/column/block
+                if ((solver->candidates[i][j] & NOTES_BIT(n)) == 0)
+                {
+                    return 0;
+                }
+                handle_number_in_cell(solver, n, i, j);
             }
         }
     }
-    
     return 1;
 }
 
-#define PV(x,y,n) ('0' + (candidates[x][y].values[n]))
+static void write_output(const SudokuSolver *solver, unsigned short int output[9][9]) {
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const unsigned short int i = cell / 9, j = cell % 9;
+        output[i][j] = is_cell_unsolved(solver, cell) ? 0 : only_one_candidate_in_cell(solver, i, j);
+    }
+}
+
+int solve_from_candidates(SudokuSolver *solver, const Notes candidates[81], unsigned short int output[9][9]) {
+    init_candidates(solver);
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        solver->candidates[cell / 9][cell % 9] = candidates[cell];
+    }
+
+    // Cells down to one candidate are placed, so they leave the unsolved set and the free values of their units
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const Notes notes = candidates[cell];
+        if ((notes & (notes - 1)) == 0)
+        {
+            handle_number_in_cell(solver, __builtin_ctz(notes) + 1, cell / 9, cell % 9);
+        }
+    }
+    solver->dirty_units = (1u << 27) - 1;
+
+    const int solvable = search(solver, NULL);
+    write_output(solver, output);
+    return solvable;
+}
 
-void print_candidates_table() {
+/*
+ * Adds the time since `started` to `phase` of `trace`, and returns the current time, where the next phase starts
+ * Without a trace the clock is not even read
+ */
+static unsigned long long trace_phase(SudokuTrace *trace, SudokuPhase phase, unsigned long long started) {
+#if SUDOKU_TRACE
+    if (trace != NULL)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        const unsigned long long now = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+        if (started != 0)
+        {
+            trace->phase_ns[phase] += now - started;
+        }
+        return now;
+    }
+#else
+    (void)trace;
+    (void)phase;
+    (void)started;
+#endif
+    return 0;
+}
+
+#define PV(x,y,n) ((solver->candidates[x][y] & NOTES_BIT((n) + 1)) != 0 ? '1' + (n) : '0')
+
+static void print_candidates_table(const SudokuSolver *solver) {
     printf("┏━━━━━┯━━━━━┯━━━━━┳━━━━━┯━━━━━┯━━━━━┳━━━━━┯━━━━━┯━━━━━┓\n");
     printf("┃ %c%c%c ┊ %c%c%c ┊ %c%c%c ┃ %c%c%c ┊ %c%c%c ┊ %c%c%c ┃ %c%c%c ┊ %c%c%c ┊ %c%c%c ┃\n", PV(0,0,0) == '0' ? ' ' : PV(0,0,0), PV(0,0,1) == '0' ? ' ' : PV(0,0,1), PV(0,0,2) == '0' ? ' ' : PV(0,0,2), PV(0,1,0) == '0' ? ' ' : PV(0,1,0), PV(0,1,1) == '0' ? ' ' : PV(0,1,1), PV(0,1,2) == '0' ? ' ' : PV(0,1,2), PV(0,2,0) == '0' ? ' ' : PV(0,2,0), PV(0,2,1) == '0' ? ' ' : PV(0,2,1), PV(0,2,2) == '0' ? ' ' : PV(0,2,2), PV(0,3,0) == '0' ? ' ' : PV(0,3,0), PV(0,3,1) == '0' ? ' ' : PV(0,3,1), PV(0,3,2) == '0' ? ' ' : PV(0,3,2), PV(0,4,0) == '0' ? ' ' : PV(0,4,0), PV(0,4,1) == '0' ? ' ' : PV(0,4,1), PV(0,4,2) == '0' ? ' ' : PV(0,4,2), PV(0,5,0) == '0' ? ' ' : PV(0,5,0), PV(0,5,1) == '0' ? ' ' : PV(0,5,1), PV(0,5,2) == '0' ? ' ' : PV(0,5,2), PV(0,6,0) == '0' ? ' ' : PV(0,6,0), PV(0,6,1) == '0' ? ' ' : PV(0,6,1), PV(0,6,2) == '0' ? ' ' : PV(0,6,2), PV(0,7,0) == '0' ? ' ' : PV(0,7,0), PV(0,7,1) == '0' ? ' ' : PV(0,7,1), PV(0,7,2) == '0' ? ' ' : PV(0,7,2), PV(0,8,0) == '0' ? ' ' : PV(0,8,0), PV(0,8,1) == '0' ? ' ' : PV(0,8,1), PV(0,8,2) == '0' ? ' ' : PV(0,8,2));
     printf("┃ %c%c%c ┊ %c%c%c ┊ %c%c%c ┃ %c%c%c ┊ %c%c%c ┊ %c%c%c ┃ %c%c%c ┊ %c%c%c ┊ %c%c%c ┃\n", PV(0,0,3) == '0' ? ' ' : PV(0,0,3), PV(0,0,4) == '0' ? ' ' : PV(0,0,4), PV(0,0,5) == '0' ? ' ' : PV(0,0,5), PV(0,1,3) == '0' ? ' ' : PV(0,1,3), PV(0,1,4) == '0' ? ' ' : PV(0,1,4), PV(0,1,5) == '0' ? ' ' : PV(0,1,5), PV(0,2,3) == '0' ? ' ' : PV(0,2,3), PV(0,2,4) == '0' ? ' ' : PV(0,2,4), PV(0,2,5) == '0' ? ' ' : PV(0,2,5), PV(0,3,3) == '0' ? ' ' : PV(0,3,3), PV(0,3,4) == '0' ? ' ' : PV(0,3,4), PV(0,3,5) == '0' ? ' ' : PV(0,3,5), PV(0,4,3) == '0' ? ' ' : PV(0,4,3), PV(0,4,4) == '0' ? ' ' : PV(0,4,4), PV(0,4,5) == '0' ? ' ' : PV(0,4,5), PV(0,5,3) == '0' ? ' ' : PV(0,5,3), PV(0,5,4) == '0' ? ' ' : PV(0,5,4), PV(0,5,5) == '0' ? ' ' : PV(0,5,5), PV(0,6,3) == '0' ? ' ' : PV(0,6,3), PV(0,6,4) == '0' ? ' ' : PV(0,6,4), PV(0,6,5) == '0' ? ' ' : PV(0,6,5), PV(0,7,3) == '0' ? ' ' : PV(0,7,3), PV(0,7,4) == '0' ? ' ' : PV(0,7,4), PV(0,7,5) == '0' ? ' ' : PV(0,7,5), PV(0,8,3) == '0' ? ' ' : PV(0,8,3), PV(0,8,4) == '0' ? ' ' : PV(0,8,4), PV(0,8,5) == '0' ? ' ' : PV(0,8,5));
@@ -269,49 +540,70 @@ void print_candidates_table() {
     printf("┗━━━━━┷━━━━━┷━━━━━┻━━━━━┷━━━━━┷━━━━━┻━━━━━┷━━━━━┷━━━━━┛\n");
 }
 
-void solve_sudoku(unsigned short int input[9][9], unsigned short int output[9][9]) {
-    init_candidates();
-    
-    for (size_t i = 0; i < 9; i++)
+// -- PUBLIC -- //
+void sudoku_solver_init(SudokuSolver *solver) {
+    init_candidates(solver);
+}
+
+int sudoku_solver_solve(SudokuSolver *solver, unsigned short int input[9][9], unsigned short int output[9][9]) {
+    return sudoku_solver_solve_with_strategies(solver, NULL, 0, NULL, input, output);
+}
+
+int sudoku_solver_solve_with_strategies(SudokuSolver *solver, const SudokuStrategy *strategies, size_t strategy_count,
+                                        SudokuTrace *trace, unsigned short int input[9][9], unsigned short int output[9][9])
+{
+    init_candidates(solver);
+    // Starts the clock of the first phase
+    unsigned long long phase_start = trace_phase(trace, SUDOKU_PHASE_GIVENS, 0);
+
+    int solvable = place_givens(solver, input);
+    phase_start = trace_phase(trace, SUDOKU_PHASE_GIVENS, phase_start);
+
+    // Deductions first, guessing only for what they leave unsolved
+    if (solvable)
     {
-        for (size_t j = 0; j < 9; j++)
-        {
-            output[i][j] = input[i][j];
-        }
+        solver->trace = trace;
+        solvable = sudoku_apply_strategies(solver, strategies, strategy_count);
+        phase_start = trace_phase(trace, SUDOKU_PHASE_LOGIC, phase_start);
+
+        // Singles inside guesses may be thrown away by a backtrack, so only the guesses themselves are recorded
+        solver->trace = NULL;
+        solvable = solvable && search(solver, trace);
+        trace_phase(trace, SUDOKU_PHASE_SEARCH, phase_start);
+        solver->trace = trace;
     }
-    
-    for (size_t i = 0; i < 9; i++)
+
+    write_output(solver, output);
+    return solvable;
+}
+
+unsigned int sudoku_solver_count_solutions(SudokuSolver *solver, unsigned short int input[9][9], unsigned int limit) {
+    init_candidates(solver);
+    if (limit == 0 || !place_givens(solver, input))
     {
-        for (size_t j = 0; j < 9; j++)
-        {
-            unsigned short int n = input[i][j];
-            if (n >= 1 && n <= 9)
-            {
-                handle_number_in_cell(n, i, j);
-            }
-        }
+        return 0;
     }
+    return count_solutions(solver, limit);
+}
 
-    for (size_t x = 0; x < SUDOKU_MAX_ITERATIONS && is_not_fully_solved(output) == 0; x++)
+double sudoku_solver_grade(SudokuSolver *solver, SudokuTrace *trace, unsigned short int input[9][9], unsigned short int output[9][9]) {
+    sudoku_trace_init(trace);
+    if (!sudoku_solver_solve_with_strategies(solver, sudoku_default_strategies, sudoku_default_strategy_count, trace, input, output))
     {
-        for (size_t i = 0; i < 9; i++)
-        {
-            for (size_t j = 0; j < 9; j++)
-            {
-                unsigned short int only_candidate = only_one_candidate_in_cell(i, j);
-
-                if (input[i][j] == 0 && only_candidate != 0)
-                {
-                    output[i][j] = only_candidate;
-                    handle_number_in_cell(only_candidate, i, j);
-                }
-            }
-        }
-        check_hidden_singles();
+        return -1.0;
     }
+    return sudoku_trace_difficulty(trace);
+}
+
+void sudoku_solver_print_candidates(const SudokuSolver *solver) {
+    print_candidates_table(solver);
+}
+
+void solve_sudoku(unsigned short int input[9][9], unsigned short int output[9][9]) {
+    SudokuSolver solver;
 
-    if(is_not_fully_solved(output) == 0) {
+    if(sudoku_solver_solve_with_strategies(&solver, sudoku_default_strategies, sudoku_default_strategy_count, NULL, input, output) == 0) {
         printf("Sudoku not solved. Possible values so far:\n");
-        print_candidates_table();
+        print_candidates_table(&solver);
     }
 }
@@ -1,6 +1,83 @@
 #ifndef SUDOKU_SOLVER_H
 #define SUDOKU_SOLVER_H
 
+#include <stddef.h>
+#include "sudoku_trace.h"
+
+struct SudokuStrategy;
+
+/*
+ * Notes for a single cell, as a bitmask
+ * A cell starts by having 9 possible values (1-9), until only 1 is left, which becomes the number of the cell
+ * If bit n-1 is set then n is a possible value in this cell, so only the lower 9 bits are used
+ */
+typedef unsigned short int Notes;
+
+#define NOTES_ALL_VALUES 0x1FF
+#define NOTES_BIT(n) ((Notes)(1u << ((n) - 1)))
+
+/*
+ * All the state needed to solve one sudoku
+ * It does not own any heap memory, so it can live on the stack or anywhere the caller wants,
+ * and one solver per thread can run at the same time without any locking
+ */
+typedef struct SudokuSolver {
+    // All candidates for all cells of the board (9x9 board), by using one `Notes` per cell of the board
+    Notes candidates[9][9];
+    // Values that can still be placed in each unit, kept up to date when a number is placed: rows are units 0-8,
+    // columns 9-17 and blocks 18-26
+    Notes unit_free[27];
+    // Cells that have not been given their number yet, one bit per cell (row after row, cell i*9+j)
+    unsigned long long unsolved[2];
+    // Cells that lost a candidate and are down to one (or none) since they were last looked at, same layout
+    unsigned long long pending[2];
+    // Units that lost a candidate since they were last checked for hidden singles: rows, then columns, then blocks
+    unsigned int dirty_units;
+    // Where the deductions are recorded while solving, NULL when nothing is recorded
+    SudokuTrace *trace;
+} SudokuSolver;
+
+/*
+ * Resets the solver to an empty board, where every cell can hold every value
+ * Solving resets the solver by itself, so this is only needed before using the candidates directly
+ */
+void sudoku_solver_init(SudokuSolver *solver);
+
+/*
+ * Solves `input` into `output` using only the state inside `solver`
+ * Naked and hidden singles are applied, driven by the cells and units that changed, and when they stop making
+ * progress the solver guesses the value of the cell with the fewest candidates left and backtracks on contradictions,
+ * so every valid board gets solved. This is the fastest way through large batches of puzzles.
+ * Return 0 if the board has no solution, >0 otherwise. The candidates left are kept in `solver` either way
+ */
+int sudoku_solver_solve(SudokuSolver *solver, unsigned short int input[9][9], unsigned short int output[9][9]);
+
+/*
+ * Same as `sudoku_solver_solve`, but before any guessing it applies `strategies` (see `sudoku_apply_strategies`),
+ * so boards those strategies can crack are solved the way a human would, without guessing at all.
+ * If `trace` is not NULL, the deductions, guesses and phase timings of this solve are added to it
+ */
+int sudoku_solver_solve_with_strategies(SudokuSolver *solver, const struct SudokuStrategy *strategies, size_t strategy_count,
+                                        SudokuTrace *trace, unsigned short int input[9][9], unsigned short int output[9][9]);
+
+/*
+ * Number of solutions of `input`, where counting stops at `limit`: a limit of 2 is enough to tell a proper puzzle
+ * (exactly one solution) from one with several, without enumerating all of them
+ */
+unsigned int sudoku_solver_count_solutions(SudokuSolver *solver, unsigned short int input[9][9], unsigned int limit);
+
+/*
+ * Solves `input` with every strategy in `sudoku_default_strategies` and records how into `trace` (reset first)
+ * Return the difficulty of the board (see `sudoku_trace_difficulty`), or a negative value if it has no solution
+ */
+double sudoku_solver_grade(SudokuSolver *solver, SudokuTrace *trace, unsigned short int input[9][9], unsigned short int output[9][9]);
+
+void sudoku_solver_print_candidates(const SudokuSolver *solver);
+
+/*
+ * Solves with a solver on the stack and every strategy in `sudoku_default_strategies`,
+ * and prints the candidates left if the board could not be fully solved
+ */
 void solve_sudoku(unsigned short int input[9][9], unsigned short int output[9][9]);
 
 #endif // SUDOKU_SOLVER_H
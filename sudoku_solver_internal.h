@@ -0,0 +1,107 @@
+#ifndef SUDOKU_SOLVER_INTERNAL_H
+#define SUDOKU_SOLVER_INTERNAL_H
+
+/*
+ * Building blocks of the solver, shared by the deduction strategies
+ * Not part of the public API: they assume a consistent `SudokuSolver` and don't validate their arguments
+ */
+
+#include "sudoku_solver.h"
+#include "sudoku_trace.h"
+
+// Adds `amount` to a field of `trace` (or of the trace of `solver`), if there is one. Used for what grading reads,
+// the techniques and the guesses, so it is kept with SUDOKU_TRACE 0
+#define TRACE_ADD_TO(trace, field, amount) do { if ((trace) != NULL) (trace)->field += (amount); } while (0)
+#define TRACE_ADD(solver, field, amount) TRACE_ADD_TO((solver)->trace, field, amount)
+
+// Same as `TRACE_ADD`, for the counts only shown to people (propagation steps, eliminations). Nothing is left of it
+// with SUDOKU_TRACE 0
+#if SUDOKU_TRACE
+#define TRACE_DETAIL_ADD(solver, field, amount) TRACE_ADD(solver, field, amount)
+#else
+#define TRACE_DETAIL_ADD(solver, field, amount) ((void)(solver))
+#endif
+
+// Board index (i*9+j) of the cells of each unit: rows are units 0-8, columns 9-17 and blocks 18-26
+extern const unsigned char sudoku_unit_cells[27][9];
+
+// Bits of `dirty_units` for the row, column and block of each cell
+extern const unsigned int sudoku_cell_units[81];
+
+// Board index of the 20 cells that share a row, column or block with each cell
+extern const unsigned char sudoku_cell_peers[81][20];
+
+static inline void mark_cell(unsigned long long set[2], unsigned short int cell) {
+    set[cell / 64] |= 1ull << (cell % 64);
+}
+
+static inline int is_cell_unsolved(const SudokuSolver *solver, unsigned short int cell) {
+    return (solver->unsolved[cell / 64] >> (cell % 64)) & 1;
+}
+
+/*
+ * Removes `n` from the candidates of `cell` (board index i*9+j), and queues whatever has to be looked at again
+ * because of it: the cell itself if it is down to one candidate (or none, which is a contradiction), and its row,
+ * column and block
+ * Return 0 if `n` was not a candidate of the cell anyway, >0 otherwise
+ */
+static inline int remove_candidate(SudokuSolver *solver, unsigned short int n, unsigned short int cell) {
+    Notes *notes = &solver->candidates[0][0] + cell;
+    if ((*notes & NOTES_BIT(n)) == 0)
+    {
+        return 0;
+    }
+
+    *notes &= (Notes)~NOTES_BIT(n);
+    solver->dirty_units |= sudoku_cell_units[cell];
+    if ((*notes & (*notes - 1)) == 0)
+    {
+        mark_cell(solver->pending, cell);
+    }
+    return 1;
+}
+
+static inline int remove_candidate_from_cell(SudokuSolver *solver, unsigned short int n, unsigned short int i, unsigned short int j) {
+    return remove_candidate(solver, n, i * 9 + j);
+}
+
+static inline Notes unit_free_values(const SudokuSolver *solver, unsigned short int unit) {
+    return solver->unit_free[unit];
+}
+
+/*
+ * Places `n` in the unsolved cell (i,j) and removes it from its peers, one pass over `sudoku_cell_peers`
+ */
+void handle_number_in_cell(SudokuSolver *solver, unsigned short int n, unsigned short int i, unsigned short int j);
+
+/*
+ * Runs naked and hidden singles until nothing is left to look at
+ * Return 0 if the board reached a contradiction, >0 otherwise
+ */
+int propagate_singles(SudokuSolver *solver);
+
+/*
+ * Places the givens of `input` on a freshly initialised solver
+ * Return 0 if two givens share a row, column or block, >0 otherwise
+ */
+int place_givens(SudokuSolver *solver, unsigned short int input[9][9]);
+
+/*
+ * Unsolved cell with the fewest candidates left (minimum remaining values), or 81 if every cell is solved
+ */
+unsigned short int pick_search_cell(const SudokuSolver *solver);
+
+/*
+ * Number of solutions reachable from the current state, counting stops at `limit`
+ * Only singles and guessing are used, and `solver` is left in an unspecified state
+ */
+unsigned int count_solutions(SudokuSolver *solver, unsigned int limit);
+
+/*
+ * Solves on from `candidates` (one mask per cell, board index i*9+j), like `sudoku_solver_solve` does after
+ * the givens. Every cell must have a candidate, and no value may be the single candidate of two cells of a unit
+ * Return 0 if the board has no solution, >0 otherwise
+ */
+int solve_from_candidates(SudokuSolver *solver, const Notes candidates[81], unsigned short int output[9][9]);
+
+#endif // SUDOKU_SOLVER_INTERNAL_H
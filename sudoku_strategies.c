@@ -0,0 +1,404 @@
+#include <stddef.h>
+#include <string.h>
+#include "sudoku_strategies.h"
+#include "sudoku_solver_internal.h"
+
+// Positions inside a unit are numbered 0-8, so for a block position k is (row in block) * 3 + (column in block)
+#define BLOCK_ROW_POSITIONS(r) (0x7u << ((r) * 3))
+#define BLOCK_COLUMN_POSITIONS(c) (0x49u << (c))
+// Positions of a row (or column) that fall into its first/second/third block
+#define LINE_BLOCK_POSITIONS(g) (0x7u << ((g) * 3))
+
+// The most subsets of size 4 out of 9 masks, C(9,4)
+#define MAX_SUBSETS 126
+
+/*
+ * For each value (index n-1), the positions in `unit` of the cells that can still hold it, as a 9-bit mask
+ */
+static void unit_value_positions(const SudokuSolver *solver, unsigned short int unit, Notes positions[9]) {
+    const Notes *board = &solver->candidates[0][0];
+    memset(positions, 0, 9 * sizeof(*positions));
+
+    for (unsigned short int k = 0; k < 9; k++)
+    {
+        for (Notes values = board[sudoku_unit_cells[unit][k]]; values != 0; values &= values - 1)
+        {
+            positions[__builtin_ctz(values)] |= 1u << k;
+        }
+    }
+}
+
+static void collect_subsets(const Notes masks[9], unsigned short int size, unsigned short int start,
+                            unsigned short int chosen, unsigned short int chosen_count, Notes joined,
+                            unsigned short int found[MAX_SUBSETS], size_t *found_count)
+{
+    if (chosen_count == size)
+    {
+        if (__builtin_popcount(joined) == size)
+        {
+            found[(*found_count)++] = chosen;
+        }
+        return;
+    }
+
+    for (unsigned short int k = start; k < 9; k++)
+    {
+        const Notes next = joined | masks[k];
+        if (masks[k] == 0 || __builtin_popcount(next) > size)
+        {
+            continue;
+        }
+        collect_subsets(masks, size, k + 1, chosen | (1u << k), chosen_count + 1, next, found, found_count);
+    }
+}
+
+/*
+ * Finds every choice of `size` masks (empty masks are never chosen) whose union has exactly `size` bits
+ * Each one is written to `found` as the bitset of the indices of the chosen masks
+ * Return how many were found
+ */
+static size_t find_subsets(const Notes masks[9], unsigned short int size, unsigned short int found[MAX_SUBSETS]) {
+    size_t found_count = 0;
+    collect_subsets(masks, size, 0, 0, 0, 0, found, &found_count);
+    return found_count;
+}
+
+static Notes joined_masks(const Notes masks[9], unsigned short int chosen) {
+    Notes joined = 0;
+    for (; chosen != 0; chosen &= chosen - 1)
+    {
+        joined |= masks[__builtin_ctz(chosen)];
+    }
+    return joined;
+}
+
+static int remove_values_from_cell(SudokuSolver *solver, Notes values, unsigned short int cell) {
+    int removed = 0;
+    for (values &= solver->candidates[cell / 9][cell % 9]; values != 0; values &= values - 1)
+    {
+        removed += remove_candidate_from_cell(solver, __builtin_ctz(values) + 1, cell / 9, cell % 9);
+    }
+    return removed;
+}
+
+/*
+ * Removes `values` from the cells of `unit` at the given positions
+ */
+static int remove_values_from_unit(SudokuSolver *solver, Notes values, unsigned short int unit, Notes positions) {
+    int removed = 0;
+    for (; positions != 0; positions &= positions - 1)
+    {
+        removed += remove_values_from_cell(solver, values, sudoku_unit_cells[unit][__builtin_ctz(positions)]);
+    }
+    return removed;
+}
+
+/*
+ * Naked subsets: `size` cells of a unit that together can only hold `size` values
+ * Those values must go in those cells, so no other cell of the unit can have them
+ */
+static int naked_subsets(SudokuSolver *solver, unsigned short int size) {
+    const Notes *board = &solver->candidates[0][0];
+    unsigned short int found[MAX_SUBSETS];
+    Notes masks[9];
+    int removed = 0;
+
+    for (unsigned short int unit = 0; unit < 27; unit++)
+    {
+        Notes unsolved_positions = 0;
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            const unsigned short int cell = sudoku_unit_cells[unit][k];
+            const int count = __builtin_popcount(board[cell]);
+            masks[k] = is_cell_unsolved(solver, cell) && count >= 2 && count <= size ? board[cell] : 0;
+            unsolved_positions |= is_cell_unsolved(solver, cell) ? 1u << k : 0;
+        }
+
+        const size_t found_count = find_subsets(masks, size, found);
+        for (size_t f = 0; f < found_count; f++)
+        {
+            const Notes values = joined_masks(masks, found[f]);
+            removed += remove_values_from_unit(solver, values, unit, unsolved_positions & (Notes)~found[f]);
+        }
+    }
+    return removed;
+}
+
+/*
+ * Hidden subsets: `size` values that, inside a unit, only fit in the same `size` cells
+ * Those cells must hold those values, so every other candidate can be removed from them
+ */
+static int hidden_subsets(SudokuSolver *solver, unsigned short int size) {
+    unsigned short int found[MAX_SUBSETS];
+    Notes positions[9];
+    int removed = 0;
+
+    for (unsigned short int unit = 0; unit < 27; unit++)
+    {
+        const Notes free_values = unit_free_values(solver, unit);
+        unit_value_positions(solver, unit, positions);
+        for (unsigned short int v = 0; v < 9; v++)
+        {
+            const int count = __builtin_popcount(positions[v]);
+            if ((free_values & (1u << v)) == 0 || count < 2 || count > size)
+            {
+                positions[v] = 0;
+            }
+        }
+
+        const size_t found_count = find_subsets(positions, size, found);
+        for (size_t f = 0; f < found_count; f++)
+        {
+            const Notes cells = joined_masks(positions, found[f]);
+            removed += remove_values_from_unit(solver, (Notes)~found[f] & NOTES_ALL_VALUES, unit, cells);
+        }
+    }
+    return removed;
+}
+
+/*
+ * Pointing pairs/triples: inside a block, a value only fits in one row (or column)
+ * It has to be placed in that block, so the rest of the row (or column) can't have it
+ */
+static int pointing(SudokuSolver *solver) {
+    Notes positions[9];
+    int removed = 0;
+
+    for (unsigned short int block = 0; block < 9; block++)
+    {
+        unit_value_positions(solver, 18 + block, positions);
+        for (Notes values = unit_free_values(solver, 18 + block); values != 0; values &= values - 1)
+        {
+            const unsigned short int v = __builtin_ctz(values);
+            for (unsigned short int r = 0; r < 3; r++)
+            {
+                if (positions[v] != 0 && (positions[v] & ~BLOCK_ROW_POSITIONS(r)) == 0)
+                {
+                    const unsigned short int row = (block / 3) * 3 + r;
+                    removed += remove_values_from_unit(solver, 1u << v, row, NOTES_ALL_VALUES & ~LINE_BLOCK_POSITIONS(block % 3));
+                }
+                if (positions[v] != 0 && (positions[v] & ~BLOCK_COLUMN_POSITIONS(r)) == 0)
+                {
+                    const unsigned short int column = (block % 3) * 3 + r;
+                    removed += remove_values_from_unit(solver, 1u << v, 9 + column, NOTES_ALL_VALUES & ~LINE_BLOCK_POSITIONS(block / 3));
+                }
+            }
+        }
+    }
+    return removed;
+}
+
+/*
+ * Box/line reduction: inside a row (or column), a value only fits in one block
+ * It has to be placed in that row (or column), so the rest of the block can't have it
+ */
+static int box_line_reduction(SudokuSolver *solver) {
+    Notes positions[9];
+    int removed = 0;
+
+    for (unsigned short int line = 0; line < 18; line++)
+    {
+        unit_value_positions(solver, line, positions);
+        for (Notes values = unit_free_values(solver, line); values != 0; values &= values - 1)
+        {
+            const unsigned short int v = __builtin_ctz(values);
+            for (unsigned short int g = 0; g < 3; g++)
+            {
+                if (positions[v] == 0 || (positions[v] & ~LINE_BLOCK_POSITIONS(g)) != 0)
+                {
+                    continue;
+                }
+
+                // Row `line` crosses blocks of its band, column `line - 9` crosses blocks of its stack
+                const unsigned short int block = line < 9 ? (line / 3) * 3 + g : g * 3 + (line - 9) / 3;
+                const Notes keep = line < 9 ? BLOCK_ROW_POSITIONS(line % 3) : BLOCK_COLUMN_POSITIONS((line - 9) % 3);
+                removed += remove_values_from_unit(solver, 1u << v, 18 + block, NOTES_ALL_VALUES & ~keep);
+            }
+        }
+    }
+    return removed;
+}
+
+/*
+ * Fish (X-Wing for size 2, Swordfish for size 3): `size` rows where a value only fits in the same `size` columns
+ * Those columns get the value from those rows, so no other row can have it in those columns (and the same with
+ * rows and columns swapped)
+ */
+static int fish(SudokuSolver *solver, unsigned short int size) {
+    unsigned short int found[MAX_SUBSETS];
+    Notes positions[9];
+    Notes lines[2][9][9];
+    int removed = 0;
+
+    // lines[0][v][r] is where value v+1 fits in row r, lines[1][v][c] is where it fits in column c
+    for (unsigned short int line = 0; line < 18; line++)
+    {
+        unit_value_positions(solver, line, positions);
+        for (unsigned short int v = 0; v < 9; v++)
+        {
+            const int count = __builtin_popcount(positions[v]);
+            lines[line / 9][v][line % 9] = count >= 2 && count <= size ? positions[v] : 0;
+        }
+    }
+
+    for (unsigned short int direction = 0; direction < 2; direction++)
+    {
+        for (unsigned short int v = 0; v < 9; v++)
+        {
+            const size_t found_count = find_subsets(lines[direction][v], size, found);
+            for (size_t f = 0; f < found_count; f++)
+            {
+                // The crossing lines are columns when the base lines are rows, and the other way around
+                for (Notes cross = joined_masks(lines[direction][v], found[f]); cross != 0; cross &= cross - 1)
+                {
+                    const unsigned short int cross_unit = (1 - direction) * 9 + __builtin_ctz(cross);
+                    removed += remove_values_from_unit(solver, 1u << v, cross_unit, NOTES_ALL_VALUES & (Notes)~found[f]);
+                }
+            }
+        }
+    }
+    return removed;
+}
+
+static int cells_see_each_other(unsigned short int a, unsigned short int b) {
+    return a != b && (sudoku_cell_units[a] & sudoku_cell_units[b]) != 0;
+}
+
+/*
+ * Y-Wing: a cell with candidates {a,b} that sees a cell with {a,c} and a cell with {b,c}
+ * Whichever value the first cell takes, one of the other two must be c, so no cell that sees both of them can be c
+ */
+static int y_wing(SudokuSolver *solver) {
+    const Notes *board = &solver->candidates[0][0];
+    unsigned short int pairs[81];
+    size_t pair_count = 0;
+    int removed = 0;
+
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        if (is_cell_unsolved(solver, cell) && __builtin_popcount(board[cell]) == 2)
+        {
+            pairs[pair_count++] = cell;
+        }
+    }
+
+    for (size_t p = 0; p < pair_count; p++)
+    {
+        const unsigned short int pivot = pairs[p];
+        for (size_t x = 0; x < pair_count; x++)
+        {
+            const unsigned short int first = pairs[x];
+            const Notes shared_first = board[pivot] & board[first];
+            if (!cells_see_each_other(pivot, first) || __builtin_popcount(shared_first) != 1)
+            {
+                continue;
+            }
+
+            for (size_t y = x + 1; y < pair_count; y++)
+            {
+                const unsigned short int second = pairs[y];
+                const Notes wing_value = board[first] & board[second] & (Notes)~board[pivot];
+                if (!cells_see_each_other(pivot, second) || wing_value == 0
+                    || (board[pivot] & board[second]) == shared_first
+                    || __builtin_popcount(board[pivot] & board[second]) != 1)
+                {
+                    continue;
+                }
+
+                for (unsigned short int cell = 0; cell < 81; cell++)
+                {
+                    if (is_cell_unsolved(solver, cell) && cells_see_each_other(cell, first) && cells_see_each_other(cell, second))
+                    {
+                        removed += remove_values_from_cell(solver, wing_value, cell);
+                    }
+                }
+            }
+        }
+    }
+    return removed;
+}
+
+/*
+ * Nishio trial: in a cell with only two candidates, place one of them on a copy of the solver and follow the singles.
+ * If they run into a contradiction, that candidate is wrong.
+ * Only the contradiction is kept, never the value tried, but finding it still takes a trial, so it is recorded as one
+ * and rated above every deduction. It comes last, for the boards no deduction moves forward
+ */
+static int nishio_trials(SudokuSolver *solver) {
+    const Notes *board = &solver->candidates[0][0];
+
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        if (!is_cell_unsolved(solver, cell) || __builtin_popcount(board[cell]) != 2)
+        {
+            continue;
+        }
+
+        for (Notes values = board[cell]; values != 0; values &= values - 1)
+        {
+            const unsigned short int n = __builtin_ctz(values) + 1;
+            SudokuSolver attempt = *solver;
+            // What happens on the copy is only a test, the trial itself is what gets recorded
+            attempt.trace = NULL;
+            handle_number_in_cell(&attempt, n, cell / 9, cell % 9);
+            if (!propagate_singles(&attempt))
+            {
+                return remove_candidate_from_cell(solver, n, cell / 9, cell % 9);
+            }
+        }
+    }
+    return 0;
+}
+
+static int naked_pairs(SudokuSolver *solver) { return naked_subsets(solver, 2); }
+static int hidden_pairs(SudokuSolver *solver) { return hidden_subsets(solver, 2); }
+static int naked_triples(SudokuSolver *solver) { return naked_subsets(solver, 3); }
+static int hidden_triples(SudokuSolver *solver) { return hidden_subsets(solver, 3); }
+static int naked_quads(SudokuSolver *solver) { return naked_subsets(solver, 4); }
+static int hidden_quads(SudokuSolver *solver) { return hidden_subsets(solver, 4); }
+static int x_wing(SudokuSolver *solver) { return fish(solver, 2); }
+static int swordfish(SudokuSolver *solver) { return fish(solver, 3); }
+
+// -- PUBLIC -- //
+const SudokuStrategy sudoku_default_strategies[] = {
+    { "Pointing", SUDOKU_TECHNIQUE_POINTING, pointing },
+    { "Box/line reduction", SUDOKU_TECHNIQUE_BOX_LINE_REDUCTION, box_line_reduction },
+    { "Naked pair", SUDOKU_TECHNIQUE_NAKED_PAIR, naked_pairs },
+    { "Hidden pair", SUDOKU_TECHNIQUE_HIDDEN_PAIR, hidden_pairs },
+    { "Naked triple", SUDOKU_TECHNIQUE_NAKED_TRIPLE, naked_triples },
+    { "Hidden triple", SUDOKU_TECHNIQUE_HIDDEN_TRIPLE, hidden_triples },
+    { "X-Wing", SUDOKU_TECHNIQUE_X_WING, x_wing },
+    { "Naked quad", SUDOKU_TECHNIQUE_NAKED_QUAD, naked_quads },
+    { "Hidden quad", SUDOKU_TECHNIQUE_HIDDEN_QUAD, hidden_quads },
+    { "Y-Wing", SUDOKU_TECHNIQUE_Y_WING, y_wing },
+    { "Swordfish", SUDOKU_TECHNIQUE_SWORDFISH, swordfish },
+    { "Trial (Nishio)", SUDOKU_TECHNIQUE_TRIAL, nishio_trials },
+};
+const size_t sudoku_default_strategy_count = sizeof(sudoku_default_strategies) / sizeof(sudoku_default_strategies[0]);
+
+int sudoku_apply_strategies(SudokuSolver *solver, const SudokuStrategy *strategies, size_t count) {
+    for (;;)
+    {
+        if (!propagate_singles(solver))
+        {
+            return 0;
+        }
+        if (solver->unsolved[0] == 0 && solver->unsolved[1] == 0)
+        {
+            return 1;
+        }
+
+        size_t k = 0;
+        int removed = 0;
+        while (k < count && (removed = strategies[k].apply(solver)) == 0)
+        {
+            k++;
+        }
+        if (k == count)
+        {
+            return 1;
+        }
+        TRACE_ADD(solver, uses[strategies[k].technique], 1);
+        TRACE_DETAIL_ADD(solver, eliminations[strategies[k].technique], removed);
+    }
+}
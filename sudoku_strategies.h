@@ -0,0 +1,37 @@
+#ifndef SUDOKU_STRATEGIES_H
+#define SUDOKU_STRATEGIES_H
+
+#include <stddef.h>
+#include "sudoku_solver.h"
+
+/*
+ * A human style deduction, which removes candidates from the board without guessing (apart from the Nishio trial,
+ * see `sudoku_default_strategies`)
+ * `apply` returns how many candidates it removed, so 0 means it found nothing to do on this board
+ */
+typedef struct SudokuStrategy {
+    const char *name;
+    // What the strategy is recorded as in a `SudokuTrace`
+    SudokuTechnique technique;
+    int (*apply)(SudokuSolver *solver);
+} SudokuStrategy;
+
+/*
+ * Every strategy this solver knows, in the order they are tried:
+ * pointing pairs/triples, box/line reduction, naked pair, hidden pair, naked triple, hidden triple, X-Wing,
+ * naked quad, hidden quad, Y-Wing, Swordfish, and last the Nishio trial. The trial places a candidate on a copy of
+ * the board and removes it if the singles then reach a contradiction: that is trial and error, not a deduction, so
+ * it is recorded as SUDOKU_TECHNIQUE_TRIAL and rated above every deduction, just below guessing
+ */
+extern const SudokuStrategy sudoku_default_strategies[];
+extern const size_t sudoku_default_strategy_count;
+
+/*
+ * Applies naked and hidden singles, and only when those stall, the first of `strategies` that finds something.
+ * After every strategy that removes candidates it starts again from the singles, so the expensive strategies only
+ * run on boards that none of the cheaper ones can move forward.
+ * Return 0 if the board reached a contradiction, >0 otherwise (solved, or stalled with the candidates left in `solver`)
+ */
+int sudoku_apply_strategies(SudokuSolver *solver, const SudokuStrategy *strategies, size_t count);
+
+#endif // SUDOKU_STRATEGIES_H
@@ -0,0 +1,142 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include <stdio.h>
+#include "sudoku_trace.h"
+
+typedef struct TechniqueInfo {
+    const char *name;
+    double rating;
+} TechniqueInfo;
+
+// Ratings follow the scale most graders use, where the singles are 1-1.5, a trial 8.5 and guessing 9
+static const TechniqueInfo techniques[SUDOKU_TECHNIQUE_COUNT] = {
+    [SUDOKU_TECHNIQUE_NAKED_SINGLE]         = { "Naked single",          1.0 },
+    [SUDOKU_TECHNIQUE_HIDDEN_SINGLE_ROW]    = { "Hidden single (row)",    1.5 },
+    [SUDOKU_TECHNIQUE_HIDDEN_SINGLE_COLUMN] = { "Hidden single (column)", 1.5 },
+    [SUDOKU_TECHNIQUE_HIDDEN_SINGLE_BLOCK]  = { "Hidden single (block)",  1.2 },
+    [SUDOKU_TECHNIQUE_POINTING]             = { "Pointing",              2.6 },
+    [SUDOKU_TECHNIQUE_BOX_LINE_REDUCTION]   = { "Box/line reduction",    2.8 },
+    [SUDOKU_TECHNIQUE_NAKED_PAIR]           = { "Naked pair",            3.0 },
+    [SUDOKU_TECHNIQUE_HIDDEN_PAIR]          = { "Hidden pair",           3.4 },
+    [SUDOKU_TECHNIQUE_NAKED_TRIPLE]         = { "Naked triple",          3.6 },
+    [SUDOKU_TECHNIQUE_HIDDEN_TRIPLE]        = { "Hidden triple",         4.0 },
+    [SUDOKU_TECHNIQUE_X_WING]               = { "X-Wing",                3.2 },
+    [SUDOKU_TECHNIQUE_NAKED_QUAD]           = { "Naked quad",            5.0 },
+    [SUDOKU_TECHNIQUE_HIDDEN_QUAD]          = { "Hidden quad",           5.4 },
+    [SUDOKU_TECHNIQUE_Y_WING]               = { "Y-Wing",                4.2 },
+    [SUDOKU_TECHNIQUE_SWORDFISH]            = { "Swordfish",             3.8 },
+    // Trying a value and seeing where it leads is a trial, not a deduction: above every deduction, and only short of
+    // guessing because a single value is tried and nothing is ever backtracked
+    [SUDOKU_TECHNIQUE_TRIAL]                = { "Trial (Nishio)",        8.5 },
+};
+
+#define GUESSING_RATING 9.0
+
+// Each band goes from its own `from` up to the `from` of the next one
+static const struct {
+    const char *label;
+    double from;
+} difficulty_bands[] = {
+    { "Easy",       0.0 },
+    { "Medium",     2.0 },
+    { "Hard",       3.0 },
+    { "Expert",     4.5 },
+    { "Diabolical", GUESSING_RATING },
+};
+#define DIFFICULTY_BANDS (sizeof(difficulty_bands) / sizeof(difficulty_bands[0]))
+
+static const char *phase_names[SUDOKU_PHASE_COUNT] = {
+    [SUDOKU_PHASE_GIVENS] = "Givens",
+    [SUDOKU_PHASE_LOGIC]  = "Logic",
+    [SUDOKU_PHASE_SEARCH] = "Search",
+};
+
+// -- PUBLIC -- //
+void sudoku_trace_init(SudokuTrace *trace) {
+    memset(trace, 0, sizeof(*trace));
+}
+
+void sudoku_trace_merge(SudokuTrace *total, const SudokuTrace *part) {
+    for (size_t t = 0; t < SUDOKU_TECHNIQUE_COUNT; t++)
+    {
+        total->uses[t] += part->uses[t];
+        total->eliminations[t] += part->eliminations[t];
+    }
+    total->propagation_steps += part->propagation_steps;
+    total->guesses += part->guesses;
+    total->dead_ends += part->dead_ends;
+    for (size_t p = 0; p < SUDOKU_PHASE_COUNT; p++)
+    {
+        total->phase_ns[p] += part->phase_ns[p];
+    }
+}
+
+const char *sudoku_technique_name(SudokuTechnique technique) {
+    assert(technique < SUDOKU_TECHNIQUE_COUNT && "Unknown technique");
+    return techniques[technique].name;
+}
+
+double sudoku_technique_rating(SudokuTechnique technique) {
+    assert(technique < SUDOKU_TECHNIQUE_COUNT && "Unknown technique");
+    return techniques[technique].rating;
+}
+
+double sudoku_trace_difficulty(const SudokuTrace *trace) {
+    if (trace->guesses > 0)
+    {
+        // Bit length of the guess count, so 1 guess is 9.1, 2-3 are 9.2, 4-7 are 9.3 and so on
+        return GUESSING_RATING + 0.1 * (64 - __builtin_clzll(trace->guesses));
+    }
+
+    double hardest = 0.0;
+    for (size_t t = 0; t < SUDOKU_TECHNIQUE_COUNT; t++)
+    {
+        if (trace->uses[t] > 0 && techniques[t].rating > hardest)
+        {
+            hardest = techniques[t].rating;
+        }
+    }
+    return hardest;
+}
+
+const char *sudoku_difficulty_label(double difficulty) {
+    size_t band = 0;
+    while (band + 1 < DIFFICULTY_BANDS && difficulty >= difficulty_bands[band + 1].from)
+    {
+        band++;
+    }
+    return difficulty_bands[band].label;
+}
+
+int sudoku_difficulty_range(const char *label, double *min, double *max) {
+    for (size_t band = 0; band < DIFFICULTY_BANDS; band++)
+    {
+        if (strcasecmp(label, difficulty_bands[band].label) == 0)
+        {
+            *min = difficulty_bands[band].from;
+            *max = band + 1 < DIFFICULTY_BANDS ? difficulty_bands[band + 1].from : SUDOKU_DIFFICULTY_MAX;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void sudoku_trace_print(FILE *stream, const SudokuTrace *trace) {
+    fprintf(stream, "%-22s %12s %12s\n", "Technique", "Uses", "Eliminations");
+    for (size_t t = 0; t < SUDOKU_TECHNIQUE_COUNT; t++)
+    {
+        if (trace->uses[t] > 0)
+        {
+            fprintf(stream, "%-22s %12llu %12llu\n", techniques[t].name, trace->uses[t], trace->eliminations[t]);
+        }
+    }
+    fprintf(stream, "Propagation steps: %llu, guesses: %llu, dead ends: %llu\n",
+            trace->propagation_steps, trace->guesses, trace->dead_ends);
+    for (size_t p = 0; p < SUDOKU_PHASE_COUNT; p++)
+    {
+        fprintf(stream, "%s: %.3f ms%s", phase_names[p], trace->phase_ns[p] / 1e6, p + 1 < SUDOKU_PHASE_COUNT ? ", " : "\n");
+    }
+}
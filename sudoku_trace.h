@@ -0,0 +1,105 @@
+#ifndef SUDOKU_TRACE_H
+#define SUDOKU_TRACE_H
+
+#include <stdio.h>
+
+/*
+ * Recording of how a board was solved: which deductions were applied, how much propagation it took,
+ * and where the time went. Grading a puzzle means solving it with a trace and scoring the trace.
+ *
+ * Recording is compiled in by default and only costs a NULL check per deduction when no trace is given.
+ * Build with -DSUDOKU_TRACE=0 to compile out the details: propagation steps, eliminations and phase timings are then
+ * left at 0. The techniques used and the guesses are still recorded, since grading depends on them
+ */
+#ifndef SUDOKU_TRACE
+#define SUDOKU_TRACE 1
+#endif
+
+typedef enum SudokuTechnique {
+    SUDOKU_TECHNIQUE_NAKED_SINGLE,
+    SUDOKU_TECHNIQUE_HIDDEN_SINGLE_ROW,
+    SUDOKU_TECHNIQUE_HIDDEN_SINGLE_COLUMN,
+    SUDOKU_TECHNIQUE_HIDDEN_SINGLE_BLOCK,
+    SUDOKU_TECHNIQUE_POINTING,
+    SUDOKU_TECHNIQUE_BOX_LINE_REDUCTION,
+    SUDOKU_TECHNIQUE_NAKED_PAIR,
+    SUDOKU_TECHNIQUE_HIDDEN_PAIR,
+    SUDOKU_TECHNIQUE_NAKED_TRIPLE,
+    SUDOKU_TECHNIQUE_HIDDEN_TRIPLE,
+    SUDOKU_TECHNIQUE_X_WING,
+    SUDOKU_TECHNIQUE_NAKED_QUAD,
+    SUDOKU_TECHNIQUE_HIDDEN_QUAD,
+    SUDOKU_TECHNIQUE_Y_WING,
+    SUDOKU_TECHNIQUE_SWORDFISH,
+    // Nishio: a candidate whose placement leads the singles to a contradiction is removed. A trial, rated just below
+    // guessing
+    SUDOKU_TECHNIQUE_TRIAL,
+    SUDOKU_TECHNIQUE_COUNT
+} SudokuTechnique;
+
+typedef enum SudokuPhase {
+    // Placing the givens and removing them from their peers
+    SUDOKU_PHASE_GIVENS,
+    // Singles and strategies, everything done without guessing
+    SUDOKU_PHASE_LOGIC,
+    // Guessing and backtracking on what the logic left unsolved
+    SUDOKU_PHASE_SEARCH,
+    SUDOKU_PHASE_COUNT
+} SudokuPhase;
+
+/*
+ * Everything recorded while solving one board (or the sum over many, see `sudoku_trace_merge`)
+ * Only the logic phase is counted per technique: placements made while exploring guesses could be undone by
+ * a backtrack, so the search phase only counts its guesses and the guesses that led to a contradiction
+ */
+typedef struct SudokuTrace {
+    // Singles: numbers placed. Strategies: times the strategy moved the board forward
+    unsigned long long uses[SUDOKU_TECHNIQUE_COUNT];
+    // Candidates removed by each strategy (singles place numbers, so theirs stay at 0)
+    unsigned long long eliminations[SUDOKU_TECHNIQUE_COUNT];
+    // Cells and units taken from the propagation queues
+    unsigned long long propagation_steps;
+    unsigned long long guesses;
+    unsigned long long dead_ends;
+    unsigned long long phase_ns[SUDOKU_PHASE_COUNT];
+} SudokuTrace;
+
+void sudoku_trace_init(SudokuTrace *trace);
+
+/*
+ * Adds every count and timing of `part` to `total`
+ */
+void sudoku_trace_merge(SudokuTrace *total, const SudokuTrace *part);
+
+const char *sudoku_technique_name(SudokuTechnique technique);
+
+/*
+ * Difficulty of a technique for a human, from 1.0 (naked single) to 9 (guessing), on which solves that needed
+ * guessing go on up to SUDOKU_DIFFICULTY_MAX
+ */
+double sudoku_technique_rating(SudokuTechnique technique);
+
+/*
+ * Difficulty of the solve recorded in `trace`, which is the rating of the hardest technique it needed:
+ * a board is as hard as its hardest step, however many easy steps there are around it.
+ * Boards that needed guessing score 9 and up, one tenth more for every doubling of the number of guesses
+ */
+double sudoku_trace_difficulty(const SudokuTrace *trace);
+
+// No solve is rated above this, however many guesses it needed
+#define SUDOKU_DIFFICULTY_MAX 16.0
+
+/*
+ * Name of the band `difficulty` falls in: Easy, Medium, Hard, Expert or Diabolical
+ */
+const char *sudoku_difficulty_label(double difficulty);
+
+/*
+ * Difficulties [`min`, `max`) of the band named `label` (case is ignored)
+ * Return 0 if there is no band with that name, >0 otherwise
+ */
+int sudoku_difficulty_range(const char *label, double *min, double *max);
+
+void sudoku_trace_print(FILE *stream, const SudokuTrace *trace);
+
+#endif // SUDOKU_TRACE_H
@@ -2,38 +2,64 @@
 #include <assert.h>
 #include "sudoku_util.h"
 
-static void print_top_line_bold() {
-    printf("┏━━━┯━━━┯━━━┳━━━┯━━━┯━━━┳━━━┯━━━┯━━━┓\n");
-}
-
-static void print_middle_line_bold()
-{
-    printf("┣━━━┿━━━┿━━━╋━━━┿━━━┿━━━╋━━━┿━━━┿━━━┫\n");
-}
-
-static void print_middle_line_light()
-{
-    printf("┠┈┈┈┼┈┈┈┼┈┈┈╂┈┈┈┼┈┈┈┼┈┈┈╂┈┈┈┼┈┈┈┼┈┈┈┨\n");
+// Value of a cell as one character: 1-9, then A for 10, B for 11 and so on up to P for 25. `.` if empty
+static char grid_value_char(unsigned short int value) {
+    if (value == 0)
+    {
+        return '.';
+    }
+    return value <= 9 ? '0' + value : 'A' + (value - 10);
 }
 
-static void print_bottom_line_bold()
-{
-    printf("┗━━━┷━━━┷━━━┻━━━┷━━━┷━━━┻━━━┷━━━┷━━━┛\n");
-    printf(" \n");
+/*
+ * Prints a horizontal line of the board: `left`, three `fill` per cell, `light` between cells of a box,
+ * `bold` between boxes and `right` at the end
+ */
+static void print_border_line(const SudokuGrid *grid, const char *left, const char *fill, const char *light,
+                              const char *bold, const char *right) {
+    printf("%s", left);
+    for (size_t j = 0; j < grid->side; j++)
+    {
+        printf("%s%s%s", fill, fill, fill);
+        if (j + 1 < grid->side)
+        {
+            printf("%s", (j + 1) % grid->box == 0 ? bold : light);
+        }
+    }
+    printf("%s\n", right);
 }
 
-static void print_board_cell_value(unsigned short int value) {
+static void print_grid_cell_value(unsigned short int value) {
     if (value == 0)
     {
         printf("  ");
     }
     else 
     {
-        printf("%hu ", value);
+        printf("%c ", grid_value_char(value));
+    }
+}
+
+static void print_grid_line_with_values(const SudokuGrid *grid, size_t i) {
+    for (size_t j = 0; j < grid->side; j++)
+    {
+        if (j % grid->box == 0)
+        {
+            printf("┃ ");
+        }
+        else
+        {
+            printf("┊ ");
+        }
+
+        print_grid_cell_value(grid->cells[i * grid->side + j]);
     }
+    printf("┃\n");
 }
 
 static void validate_board_values(unsigned short int board[9][9]) {
+    // Only the assert reads the board, which is gone in builds with NDEBUG
+    (void)board;
     for (size_t i = 0; i < 9; i++)
     {
         for (size_t j = 0; j < 9; j++)
@@ -43,44 +69,126 @@ static void validate_board_values(unsigned short int board[9][9]) {
     }
 }
 
-static void print_line_with_values(unsigned short int board[9][9], size_t i) {
-    for (size_t j = 0; j < 9; j++)
+// -- PUBLIC -- //
+void print_sudoku(unsigned short int board[9][9])
+{
+    validate_board_values(board);
+
+    SudokuGrid grid;
+    sudoku_grid_init(&grid, 3);
+    for (size_t k = 0; k < 81; k++)
+    {
+        grid.cells[k] = (unsigned char)board[k / 9][k % 9];
+    }
+    print_grid(&grid);
+}
+
+void print_grid(const SudokuGrid *grid)
+{
+    for (size_t i = 0; i < grid->side; i++)
     {
-        if (j % 3 == 0)
+        if (i == 0)
         {
-            printf("┃ ");
+            print_border_line(grid, "┏", "━", "┯", "┳", "┓");
+        }
+        else if (i % grid->box == 0)
+        {
+            print_border_line(grid, "┣", "━", "┿", "╋", "┫");
         }
         else
         {
-            printf("┊ ");
+            print_border_line(grid, "┠", "┈", "┼", "╂", "┨");
         }
-        
-        print_board_cell_value(board[i][j]);
+
+        print_grid_line_with_values(grid, i);
     }
-    printf("┃\n");
+    print_border_line(grid, "┗", "━", "┷", "┻", "┛");
+    printf(" \n");
 }
 
-// -- PUBLIC -- //
-void print_sudoku(unsigned short int board[9][9])
+int parse_sudoku_line(const char *line, unsigned short int board[9][9])
+{
+    for (size_t k = 0; k < 81; k++)
+    {
+        const char c = line[k];
+        if (c == '.' || c == '0')
+        {
+            board[k / 9][k % 9] = 0;
+        }
+        else if (c >= '1' && c <= '9')
+        {
+            board[k / 9][k % 9] = c - '0';
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void format_sudoku_line(unsigned short int board[9][9], char line[81])
 {
     validate_board_values(board);
 
-    for (size_t i = 0; i < 9; i++)
+    for (size_t k = 0; k < 81; k++)
     {
-        if (i == 0)
+        const unsigned short int value = board[k / 9][k % 9];
+        line[k] = value == 0 ? '.' : '0' + value;
+    }
+}
+
+int parse_grid_line(const char *line, size_t length, SudokuGrid *grid)
+{
+    unsigned short int box = SUDOKU_GRID_MIN_BOX;
+    while (box <= SUDOKU_GRID_MAX_BOX && (size_t)box * box * box * box != length)
+    {
+        box++;
+    }
+    if (!sudoku_grid_init(grid, box))
+    {
+        return 0;
+    }
+
+    for (size_t k = 0; k < length; k++)
+    {
+        const char c = line[k];
+        unsigned short int value;
+        if (c == '.' || c == '0')
+        {
+            value = 0;
+        }
+        else if (c >= '1' && c <= '9')
+        {
+            value = c - '0';
+        }
+        else if (c >= 'A' && c <= 'Z')
         {
-            print_top_line_bold();
+            value = 10 + (c - 'A');
         }
-        else if (i % 3 == 0)
+        else if (c >= 'a' && c <= 'z')
         {
-            print_middle_line_bold();
+            value = 10 + (c - 'a');
         }
         else
         {
-            print_middle_line_light();
+            return 0;
+        }
+
+        if (value > grid->side)
+        {
+            return 0;
         }
+        grid->cells[k] = (unsigned char)value;
+    }
+    return 1;
+}
 
-        print_line_with_values(board, i);
+void format_grid_line(const SudokuGrid *grid, char *line)
+{
+    for (size_t k = 0; k < (size_t)grid->side * grid->side; k++)
+    {
+        assert(grid->cells[k] <= grid->side && "Invalid value in sudoku grid, cannot format");
+        line[k] = grid_value_char(grid->cells[k]);
     }
-    print_bottom_line_bold();
 }
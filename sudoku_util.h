@@ -2,7 +2,39 @@
 #define SUDOKU_UTIL_H
 
 #include <stdio.h>
+#include "sudoku_grid.h"
 
 void print_sudoku(unsigned short int board[9][9]);
 
+/*
+ * Reads a board in the one-line format: 81 characters, row after row, with `.` or `0` for empty cells
+ * Return 0 if `line` does not start with a valid board, >0 otherwise
+ */
+int parse_sudoku_line(const char *line, unsigned short int board[9][9]);
+
+/*
+ * Writes a board in the one-line format, using `.` for empty cells
+ * Exactly 81 characters are written, without a newline or a terminating null character
+ */
+void format_sudoku_line(unsigned short int board[9][9], char line[81]);
+
+/*
+ * Prints a board of any size, with the values above 9 as letters like in the one-line format
+ */
+void print_grid(const SudokuGrid *grid);
+
+/*
+ * Reads a board of any size in the one-line format: `length` characters, row after row, which must be the number
+ * of cells of a supported size (16, 81, 256 or 625). Values above 9 are letters, A for 10 up to P for 25,
+ * in either case, and `.` or `0` are empty cells
+ * Return 0 if `line` is not a valid board, >0 otherwise
+ */
+int parse_grid_line(const char *line, size_t length, SudokuGrid *grid);
+
+/*
+ * Writes a board of any size in the one-line format, using `.` for empty cells
+ * Exactly side*side characters are written, without a newline or a terminating null character
+ */
+void format_grid_line(const SudokuGrid *grid, char *line);
+
 #endif // SUDOKU_UTIL_H
@@ -0,0 +1,565 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "sudoku_variant.h"
+#include "sudoku_solver_internal.h"
+
+static void add_unit(SudokuTopology *topology, const unsigned char cells[9]) {
+    assert(topology->unit_count < SUDOKU_VARIANT_MAX_UNITS && "Too many units");
+    memcpy(topology->unit_cells[topology->unit_count], cells, 9);
+    for (unsigned short int k = 0; k < 9; k++)
+    {
+        topology->cell_units[cells[k]] |= 1ull << topology->unit_count;
+    }
+    topology->unit_count++;
+}
+
+/*
+ * Rebuilds the peer lists from the units and cages, in board order
+ */
+static void link_peers(SudokuTopology *topology) {
+    unsigned long long peers[81][2];
+    memset(peers, 0, sizeof(peers));
+    for (unsigned short int unit = 0; unit < topology->unit_count; unit++)
+    {
+        for (unsigned short int a = 0; a < 9; a++)
+        {
+            for (unsigned short int b = 0; b < 9; b++)
+            {
+                mark_cell(peers[topology->unit_cells[unit][a]], topology->unit_cells[unit][b]);
+            }
+        }
+    }
+    for (unsigned short int cage = 0; cage < topology->cage_count; cage++)
+    {
+        const SudokuCage *c = &topology->cages[cage];
+        for (unsigned short int a = 0; a < c->size; a++)
+        {
+            for (unsigned short int b = 0; b < c->size; b++)
+            {
+                mark_cell(peers[c->cells[a]], c->cells[b]);
+            }
+        }
+    }
+
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        topology->peer_count[cell] = 0;
+        for (unsigned short int other = 0; other < 81; other++)
+        {
+            if (other != cell && ((peers[cell][other / 64] >> (other % 64)) & 1))
+            {
+                topology->peers[cell][topology->peer_count[cell]++] = (unsigned char)other;
+            }
+        }
+    }
+}
+
+static unsigned short int value_sum(Notes values) {
+    unsigned short int sum = 0;
+    for (; values != 0; values &= values - 1)
+    {
+        sum += __builtin_ctz(values) + 1;
+    }
+    return sum;
+}
+
+static void variant_init(SudokuVariantSolver *solver, const SudokuTopology *topology) {
+    solver->topology = topology;
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        solver->candidates[cell] = NOTES_ALL_VALUES;
+    }
+    solver->unsolved[0] = ~0ull;
+    solver->unsolved[1] = (1ull << (81 - 64)) - 1;
+    solver->pending[0] = solver->pending[1] = 0;
+    solver->dirty_units = 0;
+    solver->dirty_cages[0] = solver->dirty_cages[1] = 0;
+}
+
+/*
+ * Marks the units and the cage of `cell` for another look, after it lost candidates
+ */
+static inline void touch_cell(SudokuVariantSolver *solver, unsigned short int cell) {
+    const SudokuTopology *topology = solver->topology;
+    solver->dirty_units |= topology->cell_units[cell];
+    if (topology->cell_cage[cell] != SUDOKU_NO_CAGE)
+    {
+        mark_cell(solver->dirty_cages, topology->cell_cage[cell]);
+    }
+}
+
+/*
+ * Removes `values` from the candidates of `cell`, and queues the cell if that leaves it one candidate (or none)
+ */
+static inline void variant_remove(SudokuVariantSolver *solver, unsigned short int cell, Notes values) {
+    Notes *notes = &solver->candidates[cell];
+    if ((*notes & values) == 0)
+    {
+        return;
+    }
+    *notes &= (Notes)~values;
+    touch_cell(solver, cell);
+    if ((*notes & (*notes - 1)) == 0)
+    {
+        mark_cell(solver->pending, cell);
+    }
+}
+
+static int is_unsolved(const SudokuVariantSolver *solver, unsigned short int cell) {
+    return (solver->unsolved[cell / 64] >> (cell % 64)) & 1;
+}
+
+/*
+ * Places `n` in the unsolved `cell` and removes it from every peer of the cell
+ */
+static void variant_place(SudokuVariantSolver *solver, unsigned short int cell, unsigned short int n) {
+    assert(is_unsolved(solver, cell) && "Cell already has a number");
+    solver->unsolved[cell / 64] &= ~(1ull << (cell % 64));
+    if (solver->candidates[cell] != NOTES_BIT(n))
+    {
+        solver->candidates[cell] = NOTES_BIT(n);
+        touch_cell(solver, cell);
+    }
+
+    const SudokuTopology *topology = solver->topology;
+    const unsigned char *peers = topology->peers[cell];
+    for (unsigned short int k = 0; k < topology->peer_count[cell]; k++)
+    {
+        variant_remove(solver, peers[k], NOTES_BIT(n));
+    }
+}
+
+/*
+ * Places every value that fits in only one cell of `unit`
+ * Return 0 if a value has no cell left in the unit or two values only fit in the same cell, >0 otherwise
+ */
+static int variant_hidden_singles(SudokuVariantSolver *solver, unsigned short int unit) {
+    const unsigned char *cells = solver->topology->unit_cells[unit];
+    Notes seen_once = 0, seen_twice = 0;
+    for (unsigned short int k = 0; k < 9; k++)
+    {
+        const Notes notes = solver->candidates[cells[k]];
+        seen_twice |= seen_once & notes;
+        seen_once |= notes;
+    }
+    if (seen_once != NOTES_ALL_VALUES)
+    {
+        return 0;
+    }
+
+    const Notes singles = seen_once & (Notes)~seen_twice;
+    if (singles == 0)
+    {
+        return 1;
+    }
+    for (unsigned short int k = 0; k < 9; k++)
+    {
+        const Notes hit = solver->candidates[cells[k]] & singles;
+        if (hit == 0 || !is_unsolved(solver, cells[k]))
+        {
+            continue;
+        }
+        if ((hit & (hit - 1)) != 0)
+        {
+            return 0;
+        }
+        variant_place(solver, cells[k], __builtin_ctz(hit) + 1);
+    }
+    return 1;
+}
+
+/*
+ * Keeps in the cells of `cage` only the values of its combinations that still fit: every cell has a candidate
+ * in the combination, and every value of the combination is a candidate of one of the cells
+ * Return 0 if no combination fits anymore, >0 otherwise
+ */
+static int variant_check_cage(SudokuVariantSolver *solver, unsigned short int cage) {
+    const SudokuCage *c = &solver->topology->cages[cage];
+    Notes all = 0;
+    for (unsigned short int k = 0; k < c->size; k++)
+    {
+        all |= solver->candidates[c->cells[k]];
+    }
+
+    Notes allowed = 0;
+    for (unsigned short int m = 0; m < c->combination_count; m++)
+    {
+        const Notes combination = c->combinations[m];
+        if ((all & combination) != combination)
+        {
+            continue;
+        }
+        unsigned short int k = 0;
+        while (k < c->size && (solver->candidates[c->cells[k]] & combination) != 0)
+        {
+            k++;
+        }
+        if (k == c->size)
+        {
+            allowed |= combination;
+        }
+    }
+    if (allowed == 0)
+    {
+        return 0;
+    }
+
+    for (unsigned short int k = 0; k < c->size; k++)
+    {
+        variant_remove(solver, c->cells[k], (Notes)~allowed & NOTES_ALL_VALUES);
+    }
+    return 1;
+}
+
+/*
+ * Runs naked and hidden singles and the cage combinations until nothing is left to look at, cells first, then
+ * units, then cages, the cheapest first like `propagate_singles`
+ * Return 0 if the board reached a contradiction, >0 otherwise
+ */
+static int variant_propagate(SudokuVariantSolver *solver) {
+    for (;;)
+    {
+        const size_t word = solver->pending[0] != 0 ? 0 : 1;
+        if (solver->pending[word] != 0)
+        {
+            const unsigned short int cell = word * 64 + __builtin_ctzll(solver->pending[word]);
+            solver->pending[word] &= solver->pending[word] - 1;
+            if (solver->candidates[cell] == 0)
+            {
+                return 0;
+            }
+            if (is_unsolved(solver, cell))
+            {
+                variant_place(solver, cell, __builtin_ctz(solver->candidates[cell]) + 1);
+            }
+            continue;
+        }
+
+        if (solver->dirty_units != 0)
+        {
+            const unsigned short int unit = __builtin_ctzll(solver->dirty_units);
+            solver->dirty_units &= solver->dirty_units - 1;
+            if (!variant_hidden_singles(solver, unit))
+            {
+                return 0;
+            }
+            continue;
+        }
+
+        const size_t cage_word = solver->dirty_cages[0] != 0 ? 0 : 1;
+        if (solver->dirty_cages[cage_word] != 0)
+        {
+            const unsigned short int cage = cage_word * 64 + __builtin_ctzll(solver->dirty_cages[cage_word]);
+            solver->dirty_cages[cage_word] &= solver->dirty_cages[cage_word] - 1;
+            if (!variant_check_cage(solver, cage))
+            {
+                return 0;
+            }
+            continue;
+        }
+
+        return 1;
+    }
+}
+
+static unsigned short int variant_pick_cell(const SudokuVariantSolver *solver) {
+    unsigned short int best_cell = 81;
+    int best_count = 10;
+    for (size_t word = 0; word < 2; word++)
+    {
+        for (unsigned long long bits = solver->unsolved[word]; bits != 0; bits &= bits - 1)
+        {
+            const unsigned short int cell = word * 64 + __builtin_ctzll(bits);
+            const int count = __builtin_popcount(solver->candidates[cell]);
+            if (count < best_count)
+            {
+                best_cell = cell;
+                best_count = count;
+                if (count <= 2)
+                {
+                    return best_cell;
+                }
+            }
+        }
+    }
+    return best_cell;
+}
+
+/*
+ * Depth first search with a copy of the solver per guess, like `search`, counting up to `limit` solutions
+ * Return the number of solutions found, with the last one left in `solver` if there are `limit` of them
+ */
+static unsigned int variant_search(SudokuVariantSolver *solver, unsigned int limit) {
+    if (!variant_propagate(solver))
+    {
+        return 0;
+    }
+    const unsigned short int cell = variant_pick_cell(solver);
+    if (cell == 81)
+    {
+        return 1;
+    }
+
+    unsigned int found = 0;
+    for (Notes options = solver->candidates[cell]; options != 0 && found < limit; options &= options - 1)
+    {
+        SudokuVariantSolver guess = *solver;
+        variant_place(&guess, cell, __builtin_ctz(options) + 1);
+        found += variant_search(&guess, limit - found);
+        if (found == limit)
+        {
+            *solver = guess;
+        }
+    }
+    return found;
+}
+
+/*
+ * Places the givens of `input`, and queues every unit and cage for a first look
+ * Return 0 if a given is out of range or conflicts with another one, >0 otherwise
+ */
+static int variant_start(SudokuVariantSolver *solver, const SudokuTopology *topology, unsigned short int input[9][9]) {
+    variant_init(solver, topology);
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        const unsigned short int n = input[cell / 9][cell % 9];
+        if (n > 9 || (n != 0 && (solver->candidates[cell] & NOTES_BIT(n)) == 0))
+        {
+            return 0;
+        }
+        if (n != 0)
+        {
+            variant_place(solver, cell, n);
+        }
+    }
+    solver->dirty_units = (1ull << topology->unit_count) - 1;
+    for (unsigned short int cage = 0; cage < topology->cage_count; cage++)
+    {
+        mark_cell(solver->dirty_cages, cage);
+    }
+    return 1;
+}
+
+// -- PUBLIC -- //
+int sudoku_topology_init(SudokuTopology *topology, unsigned int layout, const unsigned char regions[81]) {
+    memset(topology, 0, sizeof(*topology));
+    memset(topology->cell_cage, SUDOKU_NO_CAGE, sizeof(topology->cell_cage));
+
+    for (unsigned short int unit = 0; unit < 18; unit++)
+    {
+        add_unit(topology, sudoku_unit_cells[unit]);
+    }
+    if (regions == NULL)
+    {
+        for (unsigned short int unit = 18; unit < 27; unit++)
+        {
+            add_unit(topology, sudoku_unit_cells[unit]);
+        }
+    }
+    else
+    {
+        unsigned char cells[9][9], sizes[9] = {0};
+        for (unsigned short int cell = 0; cell < 81; cell++)
+        {
+            if (regions[cell] >= 9 || sizes[regions[cell]] == 9)
+            {
+                return 0;
+            }
+            cells[regions[cell]][sizes[regions[cell]]++] = (unsigned char)cell;
+        }
+        for (unsigned short int region = 0; region < 9; region++)
+        {
+            add_unit(topology, cells[region]);
+        }
+    }
+
+    if (layout & SUDOKU_LAYOUT_DIAGONAL)
+    {
+        unsigned char main[9], anti[9];
+        for (unsigned short int k = 0; k < 9; k++)
+        {
+            main[k] = (unsigned char)(k * 9 + k);
+            anti[k] = (unsigned char)(k * 9 + 8 - k);
+        }
+        add_unit(topology, main);
+        add_unit(topology, anti);
+    }
+    if (layout & SUDOKU_LAYOUT_WINDOKU)
+    {
+        static const unsigned char corners[4] = { 10, 14, 46, 50 };
+        for (unsigned short int w = 0; w < 4; w++)
+        {
+            unsigned char window[9];
+            for (unsigned short int k = 0; k < 9; k++)
+            {
+                window[k] = (unsigned char)(corners[w] + (k / 3) * 9 + k % 3);
+            }
+            add_unit(topology, window);
+        }
+    }
+
+    link_peers(topology);
+    return 1;
+}
+
+int sudoku_topology_add_cage(SudokuTopology *topology, const unsigned char *cells, unsigned short int size,
+                             unsigned short int sum)
+{
+    if (size == 0 || size > 9 || topology->cage_count == SUDOKU_VARIANT_MAX_CAGES)
+    {
+        return 0;
+    }
+    SudokuCage *cage = &topology->cages[topology->cage_count];
+    memset(cage, 0, sizeof(*cage));
+    for (unsigned short int k = 0; k < size; k++)
+    {
+        if (cells[k] >= 81 || topology->cell_cage[cells[k]] != SUDOKU_NO_CAGE)
+        {
+            return 0;
+        }
+        for (unsigned short int other = 0; other < k; other++)
+        {
+            if (cells[other] == cells[k])
+            {
+                return 0;
+            }
+        }
+        cage->cells[k] = cells[k];
+    }
+    cage->size = (unsigned char)size;
+    cage->sum = (unsigned char)sum;
+
+    for (Notes values = 1; values <= NOTES_ALL_VALUES; values++)
+    {
+        if ((unsigned short int)__builtin_popcount(values) == size && value_sum(values) == sum)
+        {
+            assert(cage->combination_count < SUDOKU_CAGE_MAX_COMBINATIONS && "More combinations than there can be");
+            cage->combinations[cage->combination_count++] = values;
+        }
+    }
+    if (cage->combination_count == 0)
+    {
+        return 0;
+    }
+
+    for (unsigned short int k = 0; k < size; k++)
+    {
+        topology->cell_cage[cells[k]] = (unsigned char)topology->cage_count;
+    }
+    topology->cage_count++;
+    link_peers(topology);
+    return 1;
+}
+
+int sudoku_topology_parse(SudokuTopology *topology, const char *spec) {
+    unsigned int layout = 0;
+    unsigned char regions[81];
+    int has_regions = 0;
+    const char *cages = NULL;
+
+    // Units first, as the cages are added to the topology they make
+    for (const char *part = spec; *part != '\0';)
+    {
+        const size_t length = strcspn(part, "+");
+        if (length == 1 && *part == 'x')
+        {
+            layout |= SUDOKU_LAYOUT_DIAGONAL;
+        }
+        else if (length == 7 && strncmp(part, "windoku", 7) == 0)
+        {
+            layout |= SUDOKU_LAYOUT_WINDOKU;
+        }
+        else if (length == 7 + 81 && strncmp(part, "jigsaw=", 7) == 0 && !has_regions)
+        {
+            for (unsigned short int cell = 0; cell < 81; cell++)
+            {
+                const char c = part[7 + cell];
+                if (c < '1' || c > '9')
+                {
+                    return 0;
+                }
+                regions[cell] = (unsigned char)(c - '1');
+            }
+            has_regions = 1;
+        }
+        else if (length > 7 + 81 && strncmp(part, "killer=", 7) == 0 && part[7 + 81] == ':' && cages == NULL)
+        {
+            cages = part + 7;
+        }
+        else if (length != 8 || strncmp(part, "standard", 8) != 0)
+        {
+            return 0;
+        }
+        part += length + (part[length] == '+');
+    }
+
+    if (!sudoku_topology_init(topology, layout, has_regions ? regions : NULL))
+    {
+        return 0;
+    }
+    if (cages == NULL)
+    {
+        return 1;
+    }
+
+    // Cages in the order their first cell appears, which is the order of the sums
+    const char *sums = cages + 82;
+    int taken[81] = {0};
+    for (unsigned short int first = 0; first < 81; first++)
+    {
+        if (cages[first] == '.' || taken[first])
+        {
+            continue;
+        }
+        unsigned char cells[9];
+        unsigned short int size = 0;
+        for (unsigned short int cell = first; cell < 81; cell++)
+        {
+            if (cages[cell] == cages[first])
+            {
+                if (size == 9)
+                {
+                    return 0;
+                }
+                cells[size++] = (unsigned char)cell;
+                taken[cell] = 1;
+            }
+        }
+
+        char *end;
+        const long sum = strtol(sums, &end, 10);
+        if (end == sums || sum <= 0 || sum > 45 || (*end != ',' && *end != '+' && *end != '\0'))
+        {
+            return 0;
+        }
+        sums = end + (*end == ',');
+        if (!sudoku_topology_add_cage(topology, cells, size, (unsigned short int)sum))
+        {
+            return 0;
+        }
+    }
+    // Every sum is used by a cage
+    return *sums == '\0' || *sums == '+';
+}
+
+int sudoku_variant_solve(SudokuVariantSolver *solver, const SudokuTopology *topology, unsigned short int input[9][9],
+                         unsigned short int output[9][9])
+{
+    const int solvable = variant_start(solver, topology, input) && variant_search(solver, 1) > 0;
+    for (unsigned short int cell = 0; cell < 81; cell++)
+    {
+        output[cell / 9][cell % 9] = solvable ? __builtin_ctz(solver->candidates[cell]) + 1 : 0;
+    }
+    return solvable;
+}
+
+unsigned int sudoku_variant_count_solutions(SudokuVariantSolver *solver, const SudokuTopology *topology,
+                                            unsigned short int input[9][9], unsigned int limit)
+{
+    if (limit == 0 || !variant_start(solver, topology, input))
+    {
+        return 0;
+    }
+    return variant_search(solver, limit);
+}
@@ -0,0 +1,107 @@
+#ifndef SUDOKU_VARIANT_H
+#define SUDOKU_VARIANT_H
+
+#include "sudoku_solver.h"
+
+/*
+ * 9x9 variants, with their layout given as data instead of code: a unit is 9 cells that hold every value once,
+ * and a cage (killer sudoku) is up to 9 cells with distinct values that add up to its sum. Standard, diagonal (X),
+ * windoku and jigsaw boards only differ by their units, and all of them, cages included, are solved by the same
+ * table driven propagation over the peers and units of each cell
+ */
+
+// Rows, columns and blocks (or jigsaw regions), then at most the two diagonals and the four windows
+#define SUDOKU_VARIANT_MAX_UNITS 33
+#define SUDOKU_VARIANT_MAX_CAGES 81
+// Most sets of distinct values with the same size and sum, reached by 20 in 4 cells and 25 in 5
+#define SUDOKU_CAGE_MAX_COMBINATIONS 12
+#define SUDOKU_NO_CAGE 0xFF
+
+// Units added to rows, columns and blocks by `sudoku_topology_init`
+#define SUDOKU_LAYOUT_DIAGONAL 1u
+#define SUDOKU_LAYOUT_WINDOKU 2u
+
+typedef struct SudokuCage {
+    unsigned char cells[9];
+    unsigned char size;
+    unsigned char sum;
+    // Every set of `size` distinct values that adds up to `sum`, one mask each
+    unsigned char combination_count;
+    Notes combinations[SUDOKU_CAGE_MAX_COMBINATIONS];
+} SudokuCage;
+
+/*
+ * Units and cages of a board, with the tables the solver runs on. Built once per layout and read only afterwards,
+ * so any number of solvers can share one
+ */
+typedef struct SudokuTopology {
+    unsigned short int unit_count;
+    // Board index (i*9+j) of the cells of each unit: rows are units 0-8, columns 9-17, blocks or regions 18-26,
+    // followed by the diagonals and the windows of the layout
+    unsigned char unit_cells[SUDOKU_VARIANT_MAX_UNITS][9];
+    // Units of each cell, bit u for unit u
+    unsigned long long cell_units[81];
+    // Cells that can't have the value of each cell, because they share a unit or a cage with it
+    unsigned char peer_count[81];
+    unsigned char peers[81][80];
+    unsigned short int cage_count;
+    SudokuCage cages[SUDOKU_VARIANT_MAX_CAGES];
+    // Cage of each cell, SUDOKU_NO_CAGE for cells outside of every cage
+    unsigned char cell_cage[81];
+} SudokuTopology;
+
+/*
+ * All the state needed to solve one variant board, like `SudokuSolver`
+ */
+typedef struct SudokuVariantSolver {
+    const SudokuTopology *topology;
+    Notes candidates[81];
+    // Cells that have not been given their number yet, one bit per cell
+    unsigned long long unsolved[2];
+    // Cells down to one candidate (or none) since they were last looked at
+    unsigned long long pending[2];
+    // Units and cages that lost a candidate since they were last checked
+    unsigned long long dirty_units;
+    unsigned long long dirty_cages[2];
+} SudokuVariantSolver;
+
+/*
+ * Rows, columns and blocks, plus the units of `layout` (SUDOKU_LAYOUT_* flags). Jigsaw boards give their
+ * `regions` in place of the blocks: the region (0-8) of every cell, 9 cells each. NULL keeps the blocks
+ * Return 0 if `regions` doesn't split the board in 9 regions of 9 cells, >0 otherwise
+ */
+int sudoku_topology_init(SudokuTopology *topology, unsigned int layout, const unsigned char regions[81]);
+
+/*
+ * Adds a killer cage of `size` cells (board index i*9+j) whose values add up to `sum`
+ * Return 0 if a cell already is in a cage or no distinct values of the cage add up to `sum`, >0 otherwise
+ */
+int sudoku_topology_add_cage(SudokuTopology *topology, const unsigned char *cells, unsigned short int size,
+                             unsigned short int sum);
+
+/*
+ * Builds the topology described by `spec`, parts separated by `+`:
+ *   standard          rows, columns and blocks only (also what an empty spec gives)
+ *   x                 both diagonals
+ *   windoku           the four windows, blocks whose top left cell is (1,1), (1,5), (5,1) or (5,5)
+ *   jigsaw=REGIONS    81 characters `1`-`9`, the region of every cell, row after row
+ *   killer=CAGES:SUMS 81 characters, `.` for a cell outside of every cage and any other character but `+` naming
+ *                     the cage of the cell, then the sums of the cages separated by `,` in the order they first appear
+ * Return 0 if the spec is not valid, >0 otherwise
+ */
+int sudoku_topology_parse(SudokuTopology *topology, const char *spec);
+
+/*
+ * Solves `input` on `topology` into `output`, with singles on every unit, the combinations of every cage and guessing
+ * Return 0 if the board has no solution, >0 otherwise
+ */
+int sudoku_variant_solve(SudokuVariantSolver *solver, const SudokuTopology *topology, unsigned short int input[9][9],
+                         unsigned short int output[9][9]);
+
+/*
+ * Number of solutions of `input` on `topology`, where counting stops at `limit`
+ */
+unsigned int sudoku_variant_count_solutions(SudokuVariantSolver *solver, const SudokuTopology *topology,
+                                            unsigned short int input[9][9], unsigned int limit);
+
+#endif // SUDOKU_VARIANT_H